@@ -0,0 +1,154 @@
+// 模型加载性能测试
+// 用法：./bench-load [model.obj] [repeat]
+
+#include <GL/glew.h>
+
+#include "mesh_loader.h"
+#include "mesh_ops.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// 原先基于 ifstream 逐词读取的解析器，作为性能与结果的对照
+// 原实现以 !fin.eof() 作为循环条件，会把最后一个面片重复读入一次，这里改为检查读取结果
+static Mesh<> load_bunny_data_istream(std::string_view obj_filename) {
+    auto eatline = [](std::istream &input) { input.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); };
+
+    ifstream fin;
+    fin.open(filesystem::path(obj_filename));
+    if (!fin.is_open()) {
+        fprintf(stderr, "Open `%s` failed\n", string(obj_filename).c_str());
+        exit(1);
+    }
+
+    Mesh<> mesh;
+    string token;
+    float x, y, z;
+    GLuint i1, i2, i3;
+    while (fin >> token) {
+        if (token == "#") {
+            eatline(fin);
+        } else if (token == "v") {
+            fin >> x >> y >> z;
+            mesh.vertices.insert(mesh.vertices.end(), {x, y, z});
+            eatline(fin);
+        } else if (token == "vn") {
+            fin >> x >> y >> z;
+            mesh.normals.insert(mesh.normals.end(), {x, y, z});
+            eatline(fin);
+        } else if (token == "f") {
+            fin >> i1;
+            fin.get();
+            fin.get();
+            fin >> i1;
+            fin >> i2;
+            fin.get();
+            fin.get();
+            fin >> i2;
+            fin >> i3;
+            fin.get();
+            fin.get();
+            fin >> i3;
+            mesh.indices.insert(mesh.indices.end(), {i1 - 1, i2 - 1, i3 - 1});
+            eatline(fin);
+        }
+    }
+    return mesh;
+}
+
+static bool same_mesh(const Mesh<> &a, const Mesh<> &b) {
+    return a.vertices == b.vertices && a.normals == b.normals && a.indices == b.indices;
+}
+
+template <typename F>
+static Mesh<> run(const char *name, F &&load, const char *filename, int repeat, double megabytes) {
+    Mesh<> mesh;
+    double best = numeric_limits<double>::max();
+    for (int i = 0; i < repeat; ++i) {
+        auto t0 = chrono::steady_clock::now();
+        mesh    = load(filename);
+        auto t1 = chrono::steady_clock::now();
+        best    = min(best, chrono::duration<double>(t1 - t0).count());
+    }
+    printf("%-10s %9.1f ms %9.1f MB/s\n", name, best * 1000.0, megabytes / best);
+    return mesh;
+}
+
+int main(int argc, char **argv) {
+    const char *filename = argc >= 2 ? argv[1] : "bunny.obj";
+    int repeat           = argc >= 3 ? atoi(argv[2]) : 3;
+
+    double megabytes = filesystem::file_size(filename) / 1e6;
+    printf("%s: %.1f MB, best of %d\n", filename, megabytes, repeat);
+
+    auto reference = run("istream", load_bunny_data_istream, filename, repeat, megabytes);
+    auto serial    = run("mmap", [](const char *f) { return load_bunny_data(f, 1); }, filename, repeat, megabytes);
+    if (!same_mesh(reference, serial)) {
+        printf("mmap: result differs from istream parser\n");
+        return 1;
+    }
+
+    // 并行解析在不同线程数下的扩展性
+    unsigned hardware_threads = max(1u, thread::hardware_concurrency());
+    for (unsigned threads = 2; threads < hardware_threads * 2; threads *= 2) {
+        unsigned n = min(threads, hardware_threads);
+        char name[32];
+        snprintf(name, sizeof(name), "mmap x%u", n);
+        auto load     = [=](const char *f) { return load_bunny_data(f, n); };
+        auto parallel = run(name, load, filename, repeat, megabytes);
+        if (!same_mesh(serial, parallel)) {
+            printf("%s: result differs from serial parser\n", name);
+            return 1;
+        }
+    }
+
+    // 数组按默认内存资源逐步增长，与预扫描后在 arena 中按精确大小分配的对比
+    // 分配次数统计的是经 pmr 内存资源的分配，峰值常驻内存取加载前后的差值
+    for (bool use_arena : {false, true}) {
+        CountingResource counting;
+        auto *previous = pmr::set_default_resource(&counting);
+        reset_peak_rss();
+        size_t base = peak_rss_bytes();
+        {
+            MeshArena arena(&counting);
+            auto t0     = chrono::steady_clock::now();
+            Mesh<> mesh = load_bunny_data(filename, 0, nullptr, nullptr, use_arena ? &arena : nullptr);
+            auto t1     = chrono::steady_clock::now();
+            size_t peak = peak_rss_bytes();
+            printf("%-10s %9.1f ms %9lu allocs %9.1f MB peak RSS (+%.1f MB), %.1f MB mesh\n",
+                   use_arena ? "arena" : "growing", chrono::duration<double, milli>(t1 - t0).count(),
+                   (unsigned long)counting.allocations(), peak / 1e6, (peak - min(peak, base)) / 1e6,
+                   (mesh.vertices.size() + mesh.normals.size() + mesh.indices.size()) * 4 / 1e6);
+        }
+        pmr::set_default_resource(previous);
+    }
+
+    // 按面积和角度加权生成法向量，串行与全局线程池对比
+    double triangles = serial.indices.size() / 3;
+    for (ThreadPool *pool : {(ThreadPool *)nullptr, &ThreadPool::global()}) {
+        Mesh<> mesh = serial;
+        double best = numeric_limits<double>::max();
+        for (int i = 0; i < repeat; ++i) {
+            auto t0 = chrono::steady_clock::now();
+            generate_normals(mesh, pool);
+            auto t1 = chrono::steady_clock::now();
+            best    = min(best, chrono::duration<double>(t1 - t0).count());
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "normals x%u", pool ? pool->size() : 1);
+        printf("%-10s %9.1f ms %9.1f Mtri/s\n", name, best * 1000.0, triangles / best / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include <GL/glew.h>
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace glss {
+
+namespace {
+
+constexpr int BVH_BINS = 16;
+// 超过该深度后按三角形个数对半划分，使树深不超过 64，遍历时可用定长的栈
+constexpr std::size_t SAH_MAX_DEPTH = 32;
+constexpr std::size_t MAX_DEPTH     = 64;
+// 遍历一个内部节点相对于求交一个三角形的代价
+constexpr float TRAVERSAL_COST = 1.0f;
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+struct Box {
+    float lo[3] = {INF, INF, INF};
+    float hi[3] = {-INF, -INF, -INF};
+
+    void grow(const float p[3]) {
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(lo[a], p[a]);
+            hi[a] = std::max(hi[a], p[a]);
+        }
+    }
+
+    void grow(const Box &b) {
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(lo[a], b.lo[a]);
+            hi[a] = std::max(hi[a], b.hi[a]);
+        }
+    }
+
+    // 表面积的一半，空包围盒为 0
+    float area() const {
+        float d[3];
+        for (int a = 0; a < 3; ++a) {
+            d[a] = std::max(0.0f, hi[a] - lo[a]);
+        }
+        return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+    }
+};
+
+// 射线与包围盒的相交区间在 (0, t_max) 内时返回进入距离，否则返回 INF
+float slab(const BvhNode &node, const float origin[3], const float inv_dir[3], float t_max) {
+    float t0 = 0.0f, t1 = t_max;
+    for (int a = 0; a < 3; ++a) {
+        float enter = (node.bounds_min[a] - origin[a]) * inv_dir[a];
+        float leave = (node.bounds_max[a] - origin[a]) * inv_dir[a];
+        if (enter > leave) {
+            std::swap(enter, leave);
+        }
+        t0 = std::max(t0, enter);
+        t1 = std::min(t1, leave);
+    }
+    return t0 <= t1 ? t0 : INF;
+}
+
+// Möller–Trumbore 射线与三角形求交，不区分正反面
+bool intersect_triangle(const float *p0, const float *p1, const float *p2, const float origin[3],
+                        const float direction[3], float &t, float &u, float &v) {
+    float e1[3], e2[3], s[3];
+    for (int a = 0; a < 3; ++a) {
+        e1[a] = p1[a] - p0[a];
+        e2[a] = p2[a] - p0[a];
+        s[a]  = origin[a] - p0[a];
+    }
+    float h[3] = {direction[1] * e2[2] - direction[2] * e2[1], direction[2] * e2[0] - direction[0] * e2[2],
+                  direction[0] * e2[1] - direction[1] * e2[0]};
+    float det  = e1[0] * h[0] + e1[1] * h[1] + e1[2] * h[2];
+    if (std::fabs(det) < 1e-12f) {
+        return false;
+    }
+    float inv_det = 1.0f / det;
+    u             = (s[0] * h[0] + s[1] * h[1] + s[2] * h[2]) * inv_det;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+    v          = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+    return t > 0.0f;
+}
+
+} // namespace
+
+Bvh build_bvh(const Mesh<> &mesh) {
+    Bvh bvh;
+    const std::size_t triangle_count = mesh.indices.size() / 3;
+    if (triangle_count == 0) {
+        return bvh;
+    }
+
+    // 各三角形的包围盒与重心
+    const GLfloat *p = mesh.vertices.data();
+    std::vector<Box> boxes(triangle_count);
+    std::vector<float> centroids(triangle_count * 3);
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+        for (int c = 0; c < 3; ++c) {
+            boxes[t].grow(p + mesh.indices[t * 3 + c] * 3);
+        }
+        for (int a = 0; a < 3; ++a) {
+            centroids[t * 3 + a] = (boxes[t].lo[a] + boxes[t].hi[a]) * 0.5f;
+        }
+    }
+
+    auto &triangles = bvh.triangles;
+    auto &nodes     = bvh.nodes;
+    triangles.resize(triangle_count);
+    std::iota(triangles.begin(), triangles.end(), GLuint(0));
+    nodes.reserve(triangle_count * 2);
+    nodes.push_back({{}, 0, {}, GLuint(triangle_count)});
+
+    // 待划分的 (节点, 深度)
+    std::vector<std::pair<std::size_t, std::size_t>> pending = {{0, 0}};
+    while (!pending.empty()) {
+        auto [n, depth] = pending.back();
+        pending.pop_back();
+        const std::size_t first = nodes[n].first, count = nodes[n].count;
+        auto begin = triangles.begin() + first, end = begin + count;
+
+        Box bounds, centers;
+        for (auto it = begin; it != end; ++it) {
+            bounds.grow(boxes[*it]);
+            centers.grow(&centroids[*it * 3]);
+        }
+        std::copy_n(bounds.lo, 3, nodes[n].bounds_min);
+        std::copy_n(bounds.hi, 3, nodes[n].bounds_max);
+        if (count <= 1) {
+            continue;
+        }
+
+        // 在各轴上分箱，扫描求出 SAH 代价最小的划分：左侧为编号小于 best_bin 的箱
+        float best_cost = INF;
+        int best_axis = -1, best_bin = 0;
+        for (int a = 0; a < 3 && depth < SAH_MAX_DEPTH; ++a) {
+            float extent = centers.hi[a] - centers.lo[a];
+            if (!(extent > 0.0f)) {
+                continue;
+            }
+            float scale = BVH_BINS / extent;
+            Box bin_bounds[BVH_BINS];
+            std::size_t bin_counts[BVH_BINS] = {};
+            for (auto it = begin; it != end; ++it) {
+                int b = std::min(BVH_BINS - 1, int((centroids[*it * 3 + a] - centers.lo[a]) * scale));
+                bin_bounds[b].grow(boxes[*it]);
+                ++bin_counts[b];
+            }
+            float right_area[BVH_BINS];
+            std::size_t right_count[BVH_BINS];
+            Box right;
+            std::size_t right_n = 0;
+            for (int b = BVH_BINS - 1; b > 0; --b) {
+                right.grow(bin_bounds[b]);
+                right_n += bin_counts[b];
+                right_area[b]  = right.area();
+                right_count[b] = right_n;
+            }
+            Box left;
+            std::size_t left_n = 0;
+            for (int b = 1; b < BVH_BINS; ++b) {
+                left.grow(bin_bounds[b - 1]);
+                left_n += bin_counts[b - 1];
+                if (left_n == 0 || right_count[b] == 0) {
+                    continue;
+                }
+                float cost = left.area() * left_n + right_area[b] * right_count[b];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = a;
+                    best_bin  = b;
+                }
+            }
+        }
+
+        // 代价与三角形面积都以节点包围盒的表面积归一化
+        float node_area = bounds.area();
+        bool split_pays = best_axis >= 0 && TRAVERSAL_COST * node_area + best_cost < count * node_area;
+        if (!split_pays && count <= BVH_MAX_LEAF_TRIANGLES) {
+            continue;
+        }
+
+        if (depth + 1 >= MAX_DEPTH) {
+            continue;
+        }
+        auto middle = begin;
+        if (best_axis >= 0) {
+            float lo = centers.lo[best_axis], scale = BVH_BINS / (centers.hi[best_axis] - lo);
+            middle = std::partition(begin, end, [&](GLuint t) {
+                return std::min(BVH_BINS - 1, int((centroids[t * 3 + best_axis] - lo) * scale)) < best_bin;
+            });
+        }
+        // 重心重合、超过深度限制等无法按 SAH 划分时对半划分
+        if (middle == begin || middle == end) {
+            middle = begin + count / 2;
+        }
+
+        GLuint left            = GLuint(nodes.size());
+        std::size_t left_count = middle - begin;
+        nodes.push_back({{}, GLuint(first), {}, GLuint(left_count)});
+        nodes.push_back({{}, GLuint(first + left_count), {}, GLuint(count - left_count)});
+        nodes[n].first = left;
+        nodes[n].count = 0;
+        pending.push_back({left, depth + 1});
+        pending.push_back({left + 1, depth + 1});
+    }
+    nodes.shrink_to_fit();
+    return bvh;
+}
+
+bool intersect_bvh(const Bvh &bvh, const Mesh<> &mesh, const GLfloat origin[3], const GLfloat direction[3],
+                   RayHit &hit) {
+    if (bvh.nodes.empty()) {
+        return false;
+    }
+    float inv_dir[3];
+    for (int a = 0; a < 3; ++a) {
+        inv_dir[a] = 1.0f / direction[a];
+    }
+
+    const GLfloat *p  = mesh.vertices.data();
+    const GLuint *ind = mesh.indices.data();
+    float best        = INF;
+    bool found        = false;
+
+    // 先访问进入距离较近的子节点，较远的入栈；树深不超过 MAX_DEPTH，栈不会溢出
+    GLuint stack[MAX_DEPTH];
+    std::size_t top = 0;
+    stack[top++]    = 0;
+    while (top > 0) {
+        const BvhNode &node = bvh.nodes[stack[--top]];
+        if (slab(node, origin, inv_dir, best) == INF) {
+            continue;
+        }
+        if (node.count == 0) {
+            GLuint closer = node.first, farther = node.first + 1;
+            float d_closer  = slab(bvh.nodes[closer], origin, inv_dir, best);
+            float d_farther = slab(bvh.nodes[farther], origin, inv_dir, best);
+            if (d_farther < d_closer) {
+                std::swap(closer, farther);
+                std::swap(d_closer, d_farther);
+            }
+            if (d_farther != INF) {
+                stack[top++] = farther;
+            }
+            if (d_closer != INF) {
+                stack[top++] = closer;
+            }
+            continue;
+        }
+        for (GLuint i = node.first; i < node.first + node.count; ++i) {
+            GLuint t = bvh.triangles[i];
+            float d, u, v;
+            if (intersect_triangle(p + ind[t * 3] * 3, p + ind[t * 3 + 1] * 3, p + ind[t * 3 + 2] * 3, origin,
+                                   direction, d, u, v) &&
+                d < best) {
+                best  = d;
+                hit   = {t, d, u, v};
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+}; // namespace glss
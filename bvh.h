@@ -0,0 +1,47 @@
+#ifndef BVH_H__
+#define BVH_H__
+
+#include "utils.h"
+
+#include <cstddef>
+#include <vector>
+
+inline namespace glss {
+
+// BVH 节点，32 字节；count 不为 0 时为叶节点，引用 triangles 中 [first, first + count) 的三角形，
+// 否则为内部节点，两个子节点为 nodes[first] 与 nodes[first + 1]
+struct BvhNode {
+    GLfloat bounds_min[3];
+    GLuint first;
+    GLfloat bounds_max[3];
+    GLuint count;
+};
+
+// 网格三角形的包围体层次，nodes[0] 为根节点；triangles 为三角形序号（第 t 个三角形的索引位于 indices 中 3t）
+struct Bvh {
+    std::vector<BvhNode> nodes;
+    std::vector<GLuint> triangles;
+};
+
+// 叶节点最多包含的三角形数
+constexpr std::size_t BVH_MAX_LEAF_TRIANGLES = 8;
+
+// 以分箱的表面积启发式（SAH）自顶向下构建 BVH：每次按三角形重心在三个轴上各分 16 个箱，
+// 取代价最小的划分；划分不比直接作为叶节点更优且三角形数不超过 BVH_MAX_LEAF_TRIANGLES 时停止
+Bvh build_bvh(const Mesh<> &mesh);
+
+// 射线与三角形的交点：origin + t * direction，(u, v) 为交点在三角形中的重心坐标
+struct RayHit {
+    GLuint triangle;
+    GLfloat t;
+    GLfloat u, v;
+};
+
+// 求射线 origin + t * direction（t > 0）与网格最近的交点，三角形正反两面都可相交；没有交点时返回 false
+// bvh 须由同一网格构建，只读取 mesh.vertices 与 mesh.indices
+bool intersect_bvh(const Bvh &bvh, const Mesh<> &mesh, const GLfloat origin[3], const GLfloat direction[3],
+                   RayHit &hit);
+
+} // namespace glss
+
+#endif
@@ -0,0 +1,117 @@
+// 编译期生成的几何体与运行时实现的对照检查，以及模型加载的正确性检查
+// 用法：./check-geometry，全部通过时返回 0
+
+#include <GL/glew.h>
+
+#include "constexpr_geometry.h"
+#include "mesh_loader.h"
+#include "mesh_ops.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// 索引完全相同，顶点坐标与法向量之差不超过 1e-5
+template <std::size_t slices, std::size_t stacks>
+static bool check_sphere() {
+    constexpr auto sphere = make_sphere<slices, stacks>();
+    Mesh<> expected       = genSolidSphere(1.0f, slices, stacks);
+    bool ok               = true;
+    auto fail             = [&](const char *what, std::size_t i) {
+        if (ok) {
+            fprintf(stderr, "sphere %lux%lu: %s differ at %lu\n", (unsigned long)slices, (unsigned long)stacks, what,
+                    (unsigned long)i);
+        }
+        ok = false;
+    };
+
+    if (expected.indices.size() != sphere.indices.size()) {
+        fail("index counts", expected.indices.size());
+    }
+    for (std::size_t i = 0; ok && i < sphere.indices.size(); ++i) {
+        if (expected.indices[i] != sphere.indices[i]) {
+            fail("indices", i);
+        }
+    }
+    if (expected.vertices.size() != sphere.vertices.size() || expected.normals.size() != sphere.normals.size()) {
+        fail("vertex counts", expected.vertices.size());
+    }
+    for (std::size_t i = 0; ok && i < sphere.vertices.size(); ++i) {
+        if (std::fabs(expected.vertices[i] - sphere.vertices[i]) > 1e-5f) {
+            fail("vertices", i);
+        }
+        if (std::fabs(expected.normals[i] - sphere.normals[i]) > 1e-5f) {
+            fail("normals", i);
+        }
+    }
+    printf("sphere %lux%lu: %s\n", (unsigned long)slices, (unsigned long)stacks, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// 在临时目录中写入测试用的模型文件，返回其路径
+static std::string write_fixture(const char *name, const char *content) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path, std::ios::binary) << content;
+    return path;
+}
+
+// 混用 v 与 v//vn 形式的角：合并后每个顶点都应有单位长度的法向量
+static bool check_mixed_corners() {
+    std::string path = write_fixture("check_mixed_corners.obj", "v 0 0 0\n"
+                                                                "v 1 0 0\n"
+                                                                "v 0 1 0\n"
+                                                                "v 1 1 0\n"
+                                                                "vn 0 0 1\n"
+                                                                "f 1//1 2//1 3//1\n"
+                                                                "f 2 4 3\n");
+    Mesh<> mesh = load_mesh(path);
+    std::filesystem::remove(path);
+    bool ok = mesh.normals.size() == mesh.vertices.size() && mesh.indices.size() == 6;
+    for (std::size_t i = 0; ok && i < mesh.normals.size(); i += 3) {
+        const GLfloat *n = &mesh.normals[i];
+        ok = std::fabs(n[0]) < 1e-5f && std::fabs(n[1]) < 1e-5f && std::fabs(n[2] - 1.0f) < 1e-5f;
+    }
+    printf("obj mixed corners: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// 位置合并：每个点与其距离小于格子边长的副本都应合并，不论二者落在格子边界的哪一侧
+static bool check_weld() {
+    constexpr std::size_t POINTS = 999;
+    constexpr float EPSILON      = 1e-3f;
+    Mesh<> mesh;
+    unsigned seed = 1;
+    auto random   = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1u << 24);
+    };
+    for (std::size_t i = 0; i < POINTS * 3; ++i) {
+        mesh.vertices.push_back(random());
+    }
+    // 包围盒对角线约为 sqrt(3)，格子边长约为 1.7 * EPSILON；副本沿 x 轴偏移不超过 1.5 * EPSILON，
+    // 常与原点落在相邻格子中，且位于本格子背向原点的一半
+    for (std::size_t i = 0; i < POINTS * 3; ++i) {
+        mesh.vertices.push_back(mesh.vertices[i] + (i % 3 == 0 ? (random() - 0.5f) * 3.0f * EPSILON : 0.0f));
+    }
+    for (GLuint t = 0; t < POINTS * 2 / 3; ++t) {
+        mesh.indices.insert(mesh.indices.end(), {t * 3, t * 3 + 1, t * 3 + 2});
+    }
+    weld_positions(mesh, EPSILON);
+    bool ok = mesh.vertices.size() == POINTS * 3 && mesh.indices.size() == POINTS * 2;
+    printf("weld positions: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() {
+    bool ok = check_sphere<3, 2>();
+    ok      = check_sphere<10, 10>() && ok;
+    ok      = check_sphere<16, 16>() && ok;
+    ok      = check_sphere<64, 32>() && ok;
+    ok      = check_mixed_corners() && ok;
+    ok      = check_weld() && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
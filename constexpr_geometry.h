@@ -0,0 +1,123 @@
+#ifndef CONSTEXPR_GEOMETRY_H__
+#define CONSTEXPR_GEOMETRY_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+inline namespace glss {
+
+// 编译期求值的数学函数
+namespace cx {
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double abs(double x) {
+    return x < 0 ? -x : x;
+}
+
+// 把 x 规约到 [-PI, PI] 后按泰勒级数求和，截断误差小于 1e-14
+constexpr double sin(double x) {
+    x -= static_cast<long long>(x / (2 * PI)) * (2 * PI);
+    if (x > PI) {
+        x -= 2 * PI;
+    } else if (x < -PI) {
+        x += 2 * PI;
+    }
+    double term = x, sum = x;
+    for (int n = 1; n <= 13; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos(double x) {
+    return sin(x + PI / 2);
+}
+
+static_assert(abs(sin(PI / 6) - 0.5) < 1e-12);
+static_assert(abs(cos(PI / 3) - 0.5) < 1e-12);
+static_assert(abs(sin(-7 * PI / 2) - 1.0) < 1e-12);
+static_assert(abs(cos(PI) + 1.0) < 1e-12);
+
+} // namespace cx
+
+// 编译期生成的单位球，顶点、法向量与索引的排列与 genSolidSphere(1, slices, stacks) 相同：
+// 先是由北向南 stacks - 1 圈、每圈 slices 个顶点，然后是北极和南极
+template <std::size_t slices, std::size_t stacks>
+struct SphereData {
+    static_assert(slices >= 3 && stacks >= 2);
+    constexpr static std::size_t VERTEX_COUNT = slices * (stacks - 1) + 2;
+    constexpr static std::size_t INDEX_COUNT  = slices * (stacks - 1) * 2 * 3;
+
+    std::array<float, VERTEX_COUNT * 3> vertices{};
+    std::array<float, VERTEX_COUNT * 3> normals{};
+    std::array<std::uint32_t, INDEX_COUNT> indices{};
+};
+
+template <std::size_t slices, std::size_t stacks>
+constexpr SphereData<slices, stacks> make_sphere() {
+    SphereData<slices, stacks> sphere;
+    std::size_t v = 0;
+    for (std::size_t i = 1; i < stacks; ++i) {
+        double latitude = cx::PI / 2 - i * cx::PI / stacks;
+        for (std::size_t j = 0; j < slices; ++j) {
+            double longtitude  = j * 2 * cx::PI / slices;
+            sphere.vertices[v] = sphere.normals[v] = float(cx::cos(latitude) * cx::cos(longtitude));
+            ++v;
+            sphere.vertices[v] = sphere.normals[v] = float(cx::cos(latitude) * cx::sin(longtitude));
+            ++v;
+            sphere.vertices[v] = sphere.normals[v] = float(cx::sin(latitude));
+            ++v;
+        }
+    }
+    // 北极、南极
+    const float poles[6] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f};
+    for (float p : poles) {
+        sphere.vertices[v] = sphere.normals[v] = p;
+        ++v;
+    }
+
+    std::size_t k = 0;
+    auto push3    = [&](std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+        sphere.indices[k++] = a;
+        sphere.indices[k++] = b;
+        sphere.indices[k++] = c;
+    };
+    for (std::size_t i = 0; i + 2 < stacks; ++i) {
+        for (std::size_t j = 0; j < slices; ++j) {
+            // 每圈最后一个四边形与第一个顶点相接
+            std::uint32_t v1 = i * slices + j;
+            std::uint32_t v2 = i * slices + (j + 1) % slices;
+            std::uint32_t v3 = (i + 1) * slices + j;
+            std::uint32_t v4 = (i + 1) * slices + (j + 1) % slices;
+            push3(v1, v3, v4);
+            push3(v1, v4, v2);
+        }
+    }
+    constexpr std::size_t vertex_count = SphereData<slices, stacks>::VERTEX_COUNT;
+    const std::uint32_t north = vertex_count - 2, south = vertex_count - 1, last_ring = slices * (stacks - 2);
+    for (std::size_t j = 0; j < slices; ++j) {
+        push3(north, j, (j + 1) % slices);
+    }
+    for (std::size_t j = 0; j + 1 < slices; ++j) {
+        push3(south, last_ring + j + 1, last_ring + j);
+    }
+    push3(south, last_ring, last_ring + slices - 1);
+    return sphere;
+}
+
+// 坐标系辅助线：三个坐标轴及各自两侧距离为 1 的平行线，每两个点一条线段
+constexpr float COORDINATE_LINES[][3] = {
+    {10.0, 0.0, 0.0},  {-10.0, 0.0, 0.0}, {10.0, 1.0, 0.0},   {-10.0, 1.0, 0.0}, {10.0, 0.0, 1.0},
+    {-10.0, 0.0, 1.0}, {10.0, -1.0, 0.0}, {-10.0, -1.0, 0.0}, {10.0, 0.0, -1.0}, {-10.0, 0.0, -1.0},
+    {0.0, 10.0, 0.0},  {0.0, -10.0, 0.0}, {1.0, 10.0, 0.0},   {1.0, -10.0, 0.0}, {0.0, 10.0, 1.0},
+    {0.0, -10.0, 1.0}, {-1.0, 10.0, 0.0}, {-1.0, -10.0, 0.0}, {0.0, 10.0, -1.0}, {0.0, -10.0, -1.0},
+    {0.0, 0.0, 10.0},  {0.0, 0.0, -10.0}, {1.0, 0.0, 10.0},   {1.0, 0.0, -10.0}, {0.0, 1.0, 10.0},
+    {0.0, 1.0, -10.0}, {-1.0, 0.0, 10.0}, {-1.0, 0.0, -10.0}, {0.0, -1.0, 10.0}, {0.0, -1.0, -10.0},
+};
+
+} // namespace glss
+
+#endif
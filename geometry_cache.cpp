@@ -0,0 +1,47 @@
+#include <GL/glew.h>
+
+#include "geometry_cache.h"
+
+namespace glss {
+
+const GpuMesh &GeometryCache::upload(const void *key, const float *vertices, std::size_t vertex_floats,
+                                     const std::uint32_t *indices, std::size_t index_count) {
+    auto [it, inserted] = meshes.try_emplace(key);
+    GpuMesh &gpu        = it->second;
+    if (!inserted) {
+        return gpu;
+    }
+
+    // 索引缓冲区的绑定记录在 VAO 中
+    GlState &state = GlState::global();
+    glGenVertexArrays(1, &gpu.vao);
+    state.bind_vertex_array(gpu.vao);
+
+    gpu.vertex_count = vertex_floats / 3;
+    glGenBuffers(1, &gpu.vbo);
+    state.bind_buffer(GL_ARRAY_BUFFER, gpu.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertex_floats * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(0);
+
+    if (index_count) {
+        gpu.index_count = index_count;
+        gpu.index_type  = GL_UNSIGNED_INT;
+        glGenBuffers(1, &gpu.ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+    }
+    state.bind_vertex_array(0);
+    return gpu;
+}
+
+void GeometryCache::release() {
+    for (auto &[key, gpu] : meshes) {
+        const GLuint buffers[] = {gpu.vbo, gpu.ibo};
+        glDeleteBuffers(2, buffers);
+        glDeleteVertexArrays(1, &gpu.vao);
+    }
+    meshes.clear();
+}
+
+}; // namespace glss
@@ -0,0 +1,60 @@
+#ifndef GEOMETRY_CACHE_H__
+#define GEOMETRY_CACHE_H__
+
+#include "constexpr_geometry.h"
+#include "gl_state.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+inline namespace glss {
+
+// 常驻显存的几何体：顶点坐标缓冲区、索引缓冲区（可为空）及绘制参数
+// vao 中顶点坐标为 0 号属性并绑定了索引缓冲区，其它属性均未启用
+struct GpuMesh {
+    GLuint vao           = 0;
+    GLuint vbo           = 0;
+    GLuint ibo           = 0;
+    GLsizei vertex_count = 0;
+    GLsizei index_count  = 0;
+    GLenum index_type    = GL_UNSIGNED_INT;
+};
+
+// 固定几何体的缓存：数据在编译期生成并位于只读段，首次使用时上传一次，之后每帧直接绘制缓冲区中的数据
+// 球体统一为单位球，半径由模型矩阵缩放
+// 需要在 OpenGL 上下文有效时调用 release 释放缓冲区
+class GeometryCache {
+public:
+    GeometryCache() = default;
+
+    GeometryCache(const GeometryCache &)            = delete;
+    GeometryCache &operator=(const GeometryCache &) = delete;
+
+    // slices × stacks 的单位球
+    template <std::size_t slices, std::size_t stacks>
+    const GpuMesh &sphere() {
+        static constexpr auto data = make_sphere<slices, stacks>();
+        return upload(&data, data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size());
+    }
+
+    // 坐标系辅助线，按 GL_LINES 绘制，没有索引
+    const GpuMesh &coordinate_lines() {
+        return upload(COORDINATE_LINES, &COORDINATE_LINES[0][0], std::size(COORDINATE_LINES) * 3, nullptr, 0);
+    }
+
+    // 删除全部缓冲区与顶点数组对象
+    void release();
+
+private:
+    // 以数据地址为键，首次请求时创建缓冲区
+    const GpuMesh &upload(const void *key, const float *vertices, std::size_t vertex_floats,
+                          const std::uint32_t *indices, std::size_t index_count);
+
+    std::map<const void *, GpuMesh> meshes;
+};
+
+} // namespace glss
+
+#endif
@@ -0,0 +1,75 @@
+#include <GL/glew.h>
+
+#include "gl_call_counter.h"
+
+namespace glss {
+
+namespace {
+
+std::size_t calls = 0;
+
+// 把 slot 替换为计数后转发给原函数的函数，驱动不提供该函数时保持为空
+// 每个被替换的函数需要各自的转发函数，用 id 区分模板实例
+template <int id, typename R, typename... Args>
+void hook(R(GLAPIENTRY *&slot)(Args...)) {
+    static R(GLAPIENTRY * original)(Args...) = nullptr;
+    struct Forward {
+        static R GLAPIENTRY call(Args... args) {
+            ++calls;
+            return original(args...);
+        }
+    };
+    if (slot && !original) {
+        original = slot;
+        slot     = Forward::call;
+    }
+}
+
+#define COUNT_GL_CALLS(name) hook<__LINE__>(__glew##name)
+
+} // namespace
+
+void install_gl_call_counter() {
+    // 程序对象与 uniform
+    COUNT_GL_CALLS(UseProgram);
+    COUNT_GL_CALLS(Uniform1i);
+    COUNT_GL_CALLS(Uniform1f);
+    COUNT_GL_CALLS(Uniform2f);
+    COUNT_GL_CALLS(Uniform4f);
+    COUNT_GL_CALLS(Uniform4fv);
+    COUNT_GL_CALLS(UniformMatrix4fv);
+    // 缓冲区
+    COUNT_GL_CALLS(BindBuffer);
+    COUNT_GL_CALLS(BindBufferBase);
+    COUNT_GL_CALLS(BufferData);
+    COUNT_GL_CALLS(BufferSubData);
+    COUNT_GL_CALLS(MapBuffer);
+    COUNT_GL_CALLS(UnmapBuffer);
+    // 顶点属性
+    COUNT_GL_CALLS(VertexAttribPointer);
+    COUNT_GL_CALLS(EnableVertexAttribArray);
+    COUNT_GL_CALLS(DisableVertexAttribArray);
+    COUNT_GL_CALLS(VertexAttrib3f);
+    COUNT_GL_CALLS(VertexAttrib4fv);
+    COUNT_GL_CALLS(VertexAttribDivisorARB);
+    COUNT_GL_CALLS(VertexAttribDivisor);
+    COUNT_GL_CALLS(BindVertexArray);
+    // 纹理与绘制
+    COUNT_GL_CALLS(ActiveTexture);
+    COUNT_GL_CALLS(BindFramebuffer);
+    COUNT_GL_CALLS(ClearBufferuiv);
+    COUNT_GL_CALLS(ClearBufferfv);
+    COUNT_GL_CALLS(MultiDrawElements);
+    COUNT_GL_CALLS(DrawElementsInstancedARB);
+    COUNT_GL_CALLS(DrawElementsInstanced);
+}
+
+std::size_t gl_call_count() {
+    return calls;
+}
+
+void add_gl_calls(std::size_t count) {
+    calls += count;
+}
+
+}; // namespace glss
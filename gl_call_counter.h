@@ -0,0 +1,28 @@
+#ifndef GL_CALL_COUNTER_H__
+#define GL_CALL_COUNTER_H__
+
+#include <cstddef>
+
+inline namespace glss {
+
+// 统计绘制时调用的 OpenGL 函数次数：把 GLEW 中常用函数的指针替换为先计数再转发的函数
+// glEnable、glDrawElements 等 GL 1.1 函数直接链接到系统库，无法替换，每帧调用的这些函数改经 counted_gl 调用
+// 需要在 glewInit 之后调用，重复调用无效果
+void install_gl_call_counter();
+
+// 安装以来统计到的调用次数，只应在 OpenGL 上下文所在线程中读取
+std::size_t gl_call_count();
+
+// 计入 count 次调用
+void add_gl_calls(std::size_t count);
+
+// 计数后调用 GL 1.1 函数，如 counted_gl(glDrawArrays, GL_LINES, 0, count)
+template <typename Function, typename... Args>
+auto counted_gl(Function function, Args... args) {
+    add_gl_calls(1);
+    return function(args...);
+}
+
+} // namespace glss
+
+#endif
@@ -0,0 +1,70 @@
+#include <GL/glew.h>
+
+#include "gl_state.h"
+
+#include "gl_call_counter.h"
+
+namespace glss {
+
+template <typename T>
+bool GlState::change(T &cached, T value) {
+    if (enabled && cached == value) {
+        ++skipped_calls;
+        return false;
+    }
+    cached = value;
+    return true;
+}
+
+void GlState::use_program(GLuint p) {
+    if (change(program, p)) {
+        glUseProgram(p);
+    }
+}
+
+void GlState::bind_vertex_array(GLuint vao) {
+    if (change(vertex_array, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void GlState::bind_buffer(GLenum target, GLuint buffer) {
+    GLuint *cached = target == GL_ARRAY_BUFFER     ? &array_buffer
+                     : target == GL_UNIFORM_BUFFER ? &uniform_buffer
+                                                   : nullptr;
+    if (!cached || change(*cached, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GlState::polygon_mode(GLenum face, GLenum mode) {
+    // GL_FRONT_AND_BACK 只有两面都已是 mode 时才跳过
+    if (face == GL_FRONT_AND_BACK) {
+        if (enabled && front_mode == mode && back_mode == mode) {
+            ++skipped_calls;
+            return;
+        }
+        front_mode = back_mode = mode;
+        counted_gl(glPolygonMode, face, mode);
+        return;
+    }
+    if (change(face == GL_FRONT ? front_mode : back_mode, mode)) {
+        counted_gl(glPolygonMode, face, mode);
+    }
+}
+
+void GlState::invalidate() {
+    program        = UNKNOWN_NAME;
+    vertex_array   = UNKNOWN_NAME;
+    array_buffer   = UNKNOWN_NAME;
+    uniform_buffer = UNKNOWN_NAME;
+    front_mode     = UNKNOWN_MODE;
+    back_mode      = UNKNOWN_MODE;
+}
+
+GlState &GlState::global() {
+    static GlState state;
+    return state;
+}
+
+}; // namespace glss
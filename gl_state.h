@@ -0,0 +1,63 @@
+#ifndef GL_STATE_H__
+#define GL_STATE_H__
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+inline namespace glss {
+
+// OpenGL 状态缓存：记录当前的程序对象、顶点数组对象、GL_ARRAY_BUFFER 与 GL_UNIFORM_BUFFER 的绑定
+// 以及正反面的多边形模式，设置与记录相同时直接跳过
+// 只在 OpenGL 上下文所在线程中使用；绕过本类修改这些状态后需调用 invalidate
+// GL_ELEMENT_ARRAY_BUFFER 的绑定属于顶点数组对象，不做缓存
+class GlState {
+public:
+    GlState() = default;
+
+    GlState(const GlState &)            = delete;
+    GlState &operator=(const GlState &) = delete;
+
+    void use_program(GLuint program);
+    void bind_vertex_array(GLuint vao);
+    void bind_buffer(GLenum target, GLuint buffer);
+    void polygon_mode(GLenum face, GLenum mode);
+
+    // 忘记记录的状态，之后的每项设置都会执行一次
+    void invalidate();
+
+    // 关闭时每次设置都直接执行，用于对比调用次数
+    void set_enabled(bool on) {
+        enabled = on;
+        invalidate();
+    }
+
+    // 被跳过的设置次数
+    std::size_t skipped() const {
+        return skipped_calls;
+    }
+
+    // 程序中共用的状态缓存
+    static GlState &global();
+
+private:
+    static constexpr GLuint UNKNOWN_NAME = ~GLuint(0);
+    static constexpr GLenum UNKNOWN_MODE = 0;
+
+    // 与记录相同时计为跳过并返回 false，否则更新记录并返回 true
+    template <typename T>
+    bool change(T &cached, T value);
+
+    bool enabled              = true;
+    GLuint program            = UNKNOWN_NAME;
+    GLuint vertex_array       = UNKNOWN_NAME;
+    GLuint array_buffer       = UNKNOWN_NAME;
+    GLuint uniform_buffer     = UNKNOWN_NAME;
+    GLenum front_mode         = UNKNOWN_MODE;
+    GLenum back_mode          = UNKNOWN_MODE;
+    std::size_t skipped_calls = 0;
+};
+
+} // namespace glss
+
+#endif
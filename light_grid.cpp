@@ -0,0 +1,132 @@
+#include <GL/glew.h>
+
+#include "light_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace glss {
+
+namespace {
+
+// 每个任务块至少处理的光源数与分块行数
+constexpr std::size_t MIN_LIGHT_BLOCK = 64;
+constexpr std::size_t MIN_ROW_BLOCK   = 4;
+
+// 光源覆盖的分块范围 [x0, x1] × [y0, y1]，x0 > x1 表示不覆盖任何分块
+struct TileRect {
+    GLint x0, y0, x1, y1;
+};
+
+TileRect light_rect(const LightSource &light, const GLfloat m[16], GLint width, GLint height, GLint tiles_x,
+                    GLint tiles_y) {
+    const TileRect all = {0, 0, tiles_x - 1, tiles_y - 1};
+    const TileRect none = {0, 0, -1, -1};
+    const GLfloat *p = light.position;
+    GLfloat r        = p[3];
+    if (r <= 0.0f) {
+        return all;
+    }
+
+    // 外接立方体的八个顶点变换到裁剪坐标，w 不大于 0 的顶点在观察点所在平面之后
+    GLfloat lo[2] = {std::numeric_limits<GLfloat>::infinity(), std::numeric_limits<GLfloat>::infinity()};
+    GLfloat hi[2] = {-std::numeric_limits<GLfloat>::infinity(), -std::numeric_limits<GLfloat>::infinity()};
+    int behind    = 0;
+    for (int c = 0; c < 8; ++c) {
+        GLfloat v[3] = {p[0] + (c & 1 ? r : -r), p[1] + (c & 2 ? r : -r), p[2] + (c & 4 ? r : -r)};
+        GLfloat clip[4];
+        for (int i = 0; i < 4; ++i) {
+            clip[i] = m[i] * v[0] + m[4 + i] * v[1] + m[8 + i] * v[2] + m[12 + i];
+        }
+        if (clip[3] <= 1e-6f) {
+            ++behind;
+            continue;
+        }
+        for (int i = 0; i < 2; ++i) {
+            GLfloat ndc = clip[i] / clip[3];
+            lo[i]       = std::min(lo[i], ndc);
+            hi[i]       = std::max(hi[i], ndc);
+        }
+    }
+    if (behind == 8) {
+        return none;
+    }
+    if (behind > 0) {
+        return all;
+    }
+
+    // 规范化设备坐标转为视口中的像素坐标
+    GLfloat x0 = (lo[0] * 0.5f + 0.5f) * width, x1 = (hi[0] * 0.5f + 0.5f) * width;
+    GLfloat y0 = (lo[1] * 0.5f + 0.5f) * height, y1 = (hi[1] * 0.5f + 0.5f) * height;
+    if (x1 < 0.0f || y1 < 0.0f || x0 >= width || y0 >= height) {
+        return none;
+    }
+    auto tile = [](GLfloat pixel, GLint tiles) {
+        return std::clamp(GLint(std::floor(pixel / LIGHT_TILE_SIZE)), 0, tiles - 1);
+    };
+    return {tile(x0, tiles_x), tile(y0, tiles_y), tile(x1, tiles_x), tile(y1, tiles_y)};
+}
+
+} // namespace
+
+void cull_light_tiles(const std::vector<LightSource> &lights, const GLfloat view_proj[16], GLint width,
+                      GLint height, LightTiles &tiles, ThreadPool *pool) {
+    const GLint tiles_x = std::max(0, (width + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE);
+    const GLint tiles_y = std::max(0, (height + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE);
+    const std::size_t tile_count = std::size_t(tiles_x) * tiles_y;
+    tiles.tiles_x                = tiles_x;
+    tiles.tiles_y                = tiles_y;
+
+    // 各光源覆盖的分块范围
+    std::vector<TileRect> rects(lights.size());
+    parallel_blocks(pool, lights.size(), block_count(pool, lights.size(), MIN_LIGHT_BLOCK),
+                    [&](std::size_t, std::size_t begin, std::size_t end) {
+                        for (std::size_t i = begin; i < end; ++i) {
+                            rects[i] = light_rect(lights[i], view_proj, width, height, tiles_x, tiles_y);
+                        }
+                    });
+
+    // 按分块行切分任务，各块只写自己的分块，无需同步
+    // 第一遍统计各分块的光源个数，前缀和得到各分块列表的起始位置
+    std::vector<std::size_t> offsets(tile_count + 1, 0);
+    std::size_t row_blocks = block_count(pool, tiles_y, MIN_ROW_BLOCK);
+    parallel_blocks(pool, tiles_y, row_blocks, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (const auto &rect : rects) {
+            GLint y0 = std::max<GLint>(rect.y0, begin), y1 = std::min<GLint>(rect.y1, end - 1);
+            for (GLint y = y0; y <= y1; ++y) {
+                for (GLint x = rect.x0; x <= rect.x1; ++x) {
+                    ++offsets[std::size_t(y) * tiles_x + x + 1];
+                }
+            }
+        }
+    });
+    for (std::size_t t = 0; t < tile_count; ++t) {
+        offsets[t + 1] += offsets[t];
+    }
+
+    // 第二遍按光源编号顺序填写各分块的列表
+    tiles.entries   = offsets[tile_count];
+    std::size_t rows = std::max<std::size_t>(1, (tiles.entries + LIGHT_LIST_WIDTH - 1) / LIGHT_LIST_WIDTH);
+    tiles.indices.resize(rows * LIGHT_LIST_WIDTH);
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+    parallel_blocks(pool, tiles_y, row_blocks, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = 0; i < rects.size(); ++i) {
+            const auto &rect = rects[i];
+            GLint y0 = std::max<GLint>(rect.y0, begin), y1 = std::min<GLint>(rect.y1, end - 1);
+            for (GLint y = y0; y <= y1; ++y) {
+                for (GLint x = rect.x0; x <= rect.x1; ++x) {
+                    tiles.indices[cursor[std::size_t(y) * tiles_x + x]++] = GLfloat(i);
+                }
+            }
+        }
+    });
+
+    tiles.grid.resize(tile_count * 2);
+    for (std::size_t t = 0; t < tile_count; ++t) {
+        tiles.grid[t * 2]     = GLfloat(offsets[t]);
+        tiles.grid[t * 2 + 1] = GLfloat(offsets[t + 1] - offsets[t]);
+    }
+}
+
+}; // namespace glss
@@ -0,0 +1,44 @@
+#ifndef LIGHT_GRID_H__
+#define LIGHT_GRID_H__
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <vector>
+
+inline namespace glss {
+
+// 光源，布局与 phong.frag 中 Lights 块的 std140 布局一致，可直接上传到 uniform 缓冲区
+struct LightSource {
+    GLfloat ambient[4];  // 环境光
+    GLfloat diffuse[4];  // 漫反射
+    GLfloat specular[4]; // 镜面反射
+    GLfloat position[4]; // 位置，第四个分量为作用半径，不大于 0 时不衰减、照亮整个画面
+};
+
+// 屏幕分块的边长（像素）
+constexpr GLint LIGHT_TILE_SIZE = 16;
+// 光源编号纹理的宽度，编号按行依次存放
+constexpr std::size_t LIGHT_LIST_WIDTH = 1024;
+
+// 分块光源列表，按浮点纹理上传：grid 为 tiles_x × tiles_y 的分块表，
+// 每个分块两个值：该分块的光源编号在 indices 中的起始位置及个数（从视口左下角开始逐行排列）
+// indices 补齐为 LIGHT_LIST_WIDTH 的整数倍（至少一行），entries 为实际的编号个数
+struct LightTiles {
+    GLint tiles_x = 0;
+    GLint tiles_y = 0;
+    std::vector<GLfloat> grid;
+    std::vector<GLfloat> indices;
+    std::size_t entries = 0;
+};
+
+// 把各光源的作用球投影到 width × height 的视口上，求出每个分块受哪些光源影响
+// view_proj 为按列存储的投影矩阵与观察矩阵之积；投影范围取作用球外接立方体八个顶点的投影包围矩形，
+// 立方体跨过观察点所在平面时视为覆盖整个视口
+// pool 不为空时各光源的投影矩形及各行分块的列表并行计算，结果与线程数无关
+void cull_light_tiles(const std::vector<LightSource> &lights, const GLfloat view_proj[16], GLint width,
+                      GLint height, LightTiles &tiles, ThreadPool *pool = nullptr);
+
+} // namespace glss
+
+#endif
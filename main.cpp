@@ -1,8 +1,18 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 
 #include <GL/glew.h>
 
@@ -20,7 +30,16 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
+#include "bvh.h"
+#include "geometry_cache.h"
+#include "gl_call_counter.h"
+#include "gl_state.h"
+#include "light_grid.h"
 #include "materials.h"
+#include "mesh_loader.h"
+#include "mesh_ops.h"
+#include "pick_buffer.h"
+#include "uniform_block.h"
 #include "utils.h"
 
 static void glfw_error_callback(int error, const char *description) {
@@ -50,22 +69,46 @@ static void print_glew_version() {
     printf("\t    run-time: %s\n", glewGetString(GLEW_VERSION));
 }
 
-struct LightSource {
-    GLfloat ambient[4];  // 环境光
-    GLfloat diffuse[4];  // 漫反射
-    GLfloat specular[4]; // 镜面反射
-    GLfloat position[4]; // 位置
+// 实例化绘制的标记球，每个实例一份
+struct MarkerInstance {
+    GLfloat center[4]; // xyz 为球心，w 为半径
+    GLfloat color[4];
+};
+
+// 着色器中 Camera 块的 std140 布局
+struct CameraBlock {
+    GLfloat view[16];
+    GLfloat proj[16];
+};
+
+// 着色器中 Shading 块的 std140 布局：材质、全局环境光及分块光源剔除的参数
+struct ShadingBlock {
+    GLfloat ambient[4];
+    GLfloat diffuse[4];
+    GLfloat specular[4];
+    GLfloat shininess;
+    GLfloat padding[3];
+    GLfloat global_ambient[4];
+    GLfloat tile_params[4];
+    GLfloat tile_counts[2];
+    GLfloat tile_rows;
+    GLint light_count;
+    GLint use_tiles;
 };
 
 class Application {
 public:
     Application(int argc, const char *const *argv) : argc(argc), argv(argv) {
-        (void)argc;
-        (void)argv;
+        parse_args();
     }
 
     int run() {
-        loadModel();
+        start_time = std::chrono::steady_clock::now();
+        // 模型在后台线程中加载，与窗口、OpenGL 及 ImGui 的初始化同时进行
+        load_thread = std::thread([this] {
+            loadModel();
+            model_ready = true;
+        });
         initWindow();
         initOpenGL();
         initImgui();
@@ -78,21 +121,117 @@ private:
     const int argc;
     const char *const *const argv;
 
-    constexpr static size_t LIGHTS = 2;
+    // 命令行参数
+    const char *model_filename = "bunny.obj";
+    bool use_mesh_cache        = true; // --no-cache：不读写二进制网格缓存
+    float weld_epsilon         = DEFAULT_WELD_EPSILON; // --weld-epsilon <值>：STL 顶点合并距离
+    bool optimize_model        = true;  // --no-optimize：不重排三角形与顶点顺序
+    bool interleaved_layout    = false; // --interleaved：位置与法向量交错存放在同一个缓冲区中
+    size_t bench_frames        = 0;     // --bench <帧数>：关闭垂直同步，模型上传后绘制指定帧数并输出平均帧时间后退出
+    bool build_lods            = true;  // --no-lod：不生成简化网格
+    bool bench_lights          = false; // --bench-lights：光源数从 2 倍增到 1024，分块剔除开、关各测一次
+    bool use_state_cache       = true;  // --no-state-cache：不跳过重复的状态设置，用于对比调用次数
+    bool core_profile          = false; // --core：创建 OpenGL 3.3 core profile 上下文，着色器按 GLSL 3.30 编译
+
+    // 光源数上限，实际上限还受 uniform 块大小的限制
+    constexpr static size_t MAX_LIGHTS = 1024;
 
     GLFWwindow *window = nullptr;
 
-    // 模型数据
-    Mesh<> model;
+    // 模型数据，三个数组都分配在 model_arena 中；加载结果使用同一 arena，移动赋值时直接接管内存
+    MeshArena model_arena;
+    Mesh<> model = make_mesh(&model_arena);
+
+    // 后台加载
+    std::thread load_thread;
+    LoadProgress load_progress;
+    std::atomic<bool> model_ready = false; // 后台线程已完成加载
+    bool model_uploaded           = false; // 模型数据已上传到缓冲区
+    bool model_reordered          = false; // 加载后重排过三角形与顶点顺序，由加载线程在 model_ready 之前写入
+    bool vbo_interleaved          = false; // VBO 中是交错存放的位置与法向量，NBO 不再使用
+
+    // 加载过程中逐段上传的模型数据
+    MeshStream model_stream;
+    struct {
+        bool allocated = false; // 缓冲区已按最终大小分配
+        bool overflow  = false; // 分段超出预分配大小，改为等待完整模型
+
+        // 预分配的和已上传的元素个数
+        size_t vertex_capacity = 0, normal_capacity = 0, index_capacity = 0;
+        size_t vertices = 0, normals = 0, indices = 0;
+
+        size_t ready_indices = 0; // 可以绘制的索引个数
+        // 已上传但引用的顶点尚未全部就绪的分段：(索引结束位置, 引用的最大顶点编号)
+        std::deque<std::pair<size_t, size_t>> waiting;
+    } stream;
+    GLsizei drawn_index_count = 0; // 绘制模型时使用的索引个数
+
+    // IBO 中的索引类型；上传完整模型时改用 16 位索引，顶点过多时切分为若干子网格分别绘制
+    GLenum index_type = GL_UNSIGNED_INT;
+    size_t index_size = sizeof(GLuint);
+    std::vector<SubMesh> model_parts;
+
+    // LOD：加载线程生成各级简化网格的索引，上传时接在完整网格的索引之后
+    // lod_ranges[l] 为第 l 级在 IBO 中的 (起始位置, 索引个数)，第 0 级是完整网格
+    constexpr static float LOD_FULL_PIXELS = 600.0f; // 投影直径不小于该值时使用完整网格
+    std::vector<std::vector<GLuint>> model_lods;
+    std::vector<std::pair<size_t, size_t>> lod_ranges;
+    GLfloat model_center[3] = {0.0f, 0.0f, 0.0f}; // 包围球，由加载线程写入
+    GLfloat model_radius    = 0.0f;
+    bool auto_lod           = true; // 按投影大小自动选择级别，否则使用 forced_lod
+    int forced_lod          = 0;
+    float lod_hysteresis    = 0.1f; // 投影大小需越过阈值的比例才切换级别，避免在阈值附近来回切换
+    size_t lod_level        = 0;
+    float projected_pixels  = 0.0f;
+
+    // meshlet 剔除：完整网格按 indices 顺序划分的 meshlet，由加载线程生成；每帧把可见的区间交给 glMultiDrawElements
+    std::vector<Meshlet> model_meshlets;
+    bool meshlet_culling = true;
+    CullStats cull_stats = {0, 0, 0, 0};
+    std::vector<std::pair<size_t, size_t>> visible_ranges;
+    // 绘制区间时复用的参数数组
+    std::vector<std::pair<size_t, size_t>> single_range = {{0, 0}};
+    std::vector<GLsizei> multi_counts;
+    std::vector<const void *> multi_offsets;
+
+    // 基准测试：开始计时的时刻及已计时的帧数
+    std::chrono::steady_clock::time_point bench_start;
+    size_t bench_count = 0;
+    // 光源基准测试的各项 (光源数, 是否分块剔除) 及当前项
+    std::vector<std::pair<size_t, bool>> bench_plan;
+    size_t bench_step = 0;
+
+    // 启动时刻，用于统计首帧时间
+    std::chrono::steady_clock::time_point start_time;
+    size_t frame_count        = 0;
+    bool model_frame_reported = false;
 
     // 缓冲区
     GLuint VBO, IBO, NBO;
+    // 模型每个子网格一个顶点数组对象，实例化绘制标记球一个；缓存的几何体各自带有 VAO
+    std::vector<GLuint> model_vaos;
+    GLuint marker_vao = 0;
+    // 上传索引时绑定的 VAO：core profile 中没有绑定 VAO 时不能绑定 IBO
+    GLuint upload_vao = 0;
+    bool instanced_markers = false; // 支持实例化绘制（core profile 或 ARB_instanced_arrays）
+    // 程序对象、VAO、缓冲区绑定与多边形模式的缓存，跳过重复的设置
+    GlState &gl_state = GlState::global();
+    // 光源提示球等程序生成的几何体
+    GeometryCache geometry;
+
+    // 光源及探针标记球的实例缓冲区，内容与上次上传的不同时才更新
+    GLuint marker_buffer = 0;
+    std::vector<MarkerInstance> marker_instances, uploaded_markers;
+    std::vector<MarkerInstance> probe_markers; // 附加的探针标记，位于包围模型的球面上
+    int probe_count = 0;                       // --markers <个数>：探针标记个数
 
     // 程序对象
-    GLuint program_phong, program_simple;
+    GLuint program_phong, program_simple, program_marker, program_pick = 0;
 
     // 模型矩阵
     glm::mat4 mat_model;
+    // 观察点位置
+    glm::vec3 eye_position;
     // 观察矩阵
     glm::mat4 mat_view;
     // 投影矩阵
@@ -105,61 +244,67 @@ private:
     // 材质参数
     Material material = materials[0];
 
-    // 光源参数
-    LightSource lights[LIGHTS] = {
+    // 光源参数，变化时上传到 uniform 缓冲区 lights_block，个数不超过 max_lights
+    std::vector<LightSource> lights = {
         {
             {0.1f, 0.1f, 0.1f, 1.0f},
             {1.0f, 1.0f, 1.0f, 1.0f},
             {1.0f, 1.0f, 1.0f, 1.0f},
-            {2.3f, 1.0f, 0.23f, 1.0f},
+            {2.3f, 1.0f, 0.23f, 0.0f},
         },
         {
             {0.1f, 0.1f, 0.1f, 1.0f},
             {1.0f, 1.0f, 1.0f, 1.0f},
             {1.0f, 1.0f, 1.0f, 1.0f},
-            {-2.5f, -0.65f, 1.5f, 1.0f},
+            {-2.5f, -0.65f, 1.5f, 0.0f},
         },
     };
+    size_t max_lights = MAX_LIGHTS;
+
+    // uniform 块：各程序共用的观察与投影矩阵、光源、材质与着色参数，内容与上次上传的不同时才更新
+    enum : GLuint { CAMERA_BINDING = 0, LIGHTS_BINDING = 1, SHADING_BINDING = 2 };
+    UniformBlock camera_block, lights_block, shading_block;
+    glm::mat4 phong_model = glm::mat4(0.0f); // 上次设置的 phong 程序模型矩阵
+
+    // 每帧调用的 OpenGL 函数次数（含经 counted_gl 调用的 GL 1.1 函数）及被状态缓存跳过的设置次数，不含 ImGui 的绘制
+    size_t frame_gl_calls = 0;
+    size_t frame_skipped  = 0;
+    size_t bench_gl_calls = 0;
+    size_t bench_skipped  = 0;
+
+    // 分块光源剔除：每帧在 CPU 上求出各屏幕分块受哪些光源影响，以浮点纹理传给片元着色器
+    bool tiled_lighting = true;
+    bool tiles_used     = false; // 本帧是否按分块着色，光源编号超出纹理尺寸时退回逐个遍历
+    LightTiles light_tiles;
+    GLuint tile_textures[2]       = {0, 0}; // 分块表与光源编号，绑定在 1、2 号纹理单元上（0 号由 ImGui 使用）
+    GLsizei tile_rows             = 0;      // 光源编号纹理的行数
+    GLint max_texture_size        = 0;
+    GLint framebuffer_viewport[4] = {0, 0, 0, 0}; // 以实际像素为单位的视口
+    GLint tiles_viewport[4]       = {0, 0, 0, 0}; // 计算分块时的视口
 
     // uniform 位置
     struct {
         struct {
             GLint model;
-            GLint view;
-            GLint proj;
         } simple;
         struct {
-            struct {
-                GLint ambient;
-                GLint diffuse;
-                GLint specular;
-                GLint position;
-            } lights[LIGHTS];
-            struct {
-                GLint ambient;
-                GLint diffuse;
-                GLint specular;
-                GLint shininess;
-            } material;
-            GLint global_ambient;
+            GLint tile_grid;
+            GLint tile_lights;
             GLint model;
-            GLint view;
-            GLint proj;
         } phong;
+        struct {
+            GLint mvp;
+            GLint id_base;
+        } pick;
     } uniform_locations;
 
 #define GET_UNIFORM_LOCATION(p, u)     uniform_locations.p.u = glGetUniformLocation(program_##p, #u)
-#define SET_UNIFORM_N(p, n, u)         glUniform##n##fv(uniform_locations.p.u, 1, u)
-#define SET_UNIFORM_1(p, u)            glUniform1f(uniform_locations.p.u, u)
 #define SET_UNIFORM_MAT_N(p, n, u)     glUniformMatrix##n##fv(uniform_locations.p.u, 1, GL_FALSE, glm::value_ptr(mat_##u))
 //
 #define GET_PHONG_UNIFORM_LOCATION(u)  GET_UNIFORM_LOCATION(phong, u)
 #define GET_SIMPLE_UNIFORM_LOCATION(u) GET_UNIFORM_LOCATION(simple, u)
 //
-#define SET_PHONG_UNIFORM4(u)          SET_UNIFORM_N(phong, 4, u)
-#define SET_PHONG_UNIFORM1(u)          SET_UNIFORM_1(phong, u)
 #define SET_PHONG_UNIFORM_MAT4(u)      SET_UNIFORM_MAT_N(phong, 4, u)
-//
 #define SET_SIMPLE_UNIFORM_MAT4(u)     SET_UNIFORM_MAT_N(simple, 4, u)
 
     // 线框颜色
@@ -183,6 +328,14 @@ private:
     GLint selected_id;              // 被选择的对象在数组中开始位置
     GLdouble select_radius = 1.0f;  // 选择视口的半径
     bool pick_sucess       = false; // 在本帧中进行拾取且成功
+    // 拾取方式：在 CPU 上用射线与 BVH 求交，或把图元编号绘制到只覆盖拾取矩形的整数帧缓冲中、下一帧读取结果
+    enum { PICK_BVH = 0, PICK_ID_BUFFER = 1 };
+    int pick_engine = PICK_BVH;
+    PickBuffer pick_buffer;
+    bool gpu_picking = false;       // 支持 ID 缓冲拾取（core profile，或 OpenGL 3.0 及 EXT_gpu_shader4）
+    int pick_mode    = SELECT_NONE; // 尚未取出的拾取结果对应的选择模式
+    // 完整网格的 BVH，由加载线程构建，用于在 CPU 上拾取
+    Bvh model_bvh;
 
     // 视口参数
     struct {
@@ -194,9 +347,6 @@ private:
                pos.y < (viewport.y + viewport.h);
     }
 
-    constexpr static size_t SELECT_BUF_SIZE = 128;
-    GLuint select_buffer[SELECT_BUF_SIZE];
-
     void initWindow() {
         // Setup window
         glfwSetErrorCallback(glfw_error_callback);
@@ -207,6 +357,13 @@ private:
 
         glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
         glfwWindowHint(GLFW_SAMPLES, 4);
+        if (core_profile) {
+            // macOS 只提供向前兼容的 core profile
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        }
         window = glfwCreateWindow(1200, 600, "Stanford Bunny", NULL, NULL);
         if (window == NULL)
             throw std::runtime_error("glfw create window failed");
@@ -218,96 +375,430 @@ private:
 
     void initOpenGL() {
         glfwMakeContextCurrent(window);
-        glfwSwapInterval(1); // Enable vsync
+        glfwSwapInterval(bench_frames ? 0 : 1); // Enable vsync，基准测试时关闭
 
         print_opengl_info();
 
         // Setup GLEW
-        // glewExperimental = GL_TRUE;
-        GLenum err = glewInit();
+        // core profile 中不能用 glGetString(GL_EXTENSIONS) 查询扩展，需要 GLEW 按 glGetStringi 加载全部函数
+        glewExperimental = core_profile ? GL_TRUE : GL_FALSE;
+        GLenum err       = glewInit();
         if (err != GLEW_OK) {
             std::string glewErrorString = (const char *)glewGetErrorString(err);
             throw std::runtime_error("glew init failed: " + glewErrorString);
         }
+        // 旧版 GLEW 在 core profile 中初始化时留下的 GL_INVALID_ENUM
+        while (glGetError() != GL_NO_ERROR) {
+        }
 
         print_glew_version();
+        install_gl_call_counter();
+
+        // 光源存放在 uniform 缓冲区中，分块光源列表存放在单、双通道浮点纹理中，绘制状态记录在顶点数组对象中
+        // 这些在 OpenGL 3.3 中都是核心功能
+        if (!core_profile && (!GLEW_ARB_uniform_buffer_object || !GLEW_ARB_texture_float || !GLEW_ARB_texture_rg ||
+                              !GLEW_ARB_vertex_array_object)) {
+            throw std::runtime_error("ARB_uniform_buffer_object, ARB_texture_float, ARB_texture_rg and "
+                                     "ARB_vertex_array_object are required");
+        }
+        instanced_markers = core_profile || GLEW_ARB_instanced_arrays;
+        gl_state.set_enabled(use_state_cache);
+        GLint block_size;
+        glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &block_size);
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+        max_lights = std::min(MAX_LIGHTS, size_t(block_size) / sizeof(LightSource));
+        if (lights.size() > max_lights) {
+            lights.resize(max_lights);
+        }
+        printf("max lights: %lu\n", (unsigned long)max_lights);
 
         // Phong 光照模型
-        program_phong = load_program("shaders/phong.vert", "shaders/phong.frag");
+        std::string phong_header = "#define MAX_LIGHTS " + std::to_string(max_lights) + "\n";
+        program_phong = load_program("shaders/phong.vert", "shaders/phong.frag", phong_header, glsl_version());
         glBindAttribLocation(program_phong, 0, "position");
         glBindAttribLocation(program_phong, 1, "normal");
         glLinkProgram(program_phong);
         get_phong_uniform_locations();
+        gl_state.use_program(program_phong);
+        glUniform1i(uniform_locations.phong.tile_grid, 1);
+        glUniform1i(uniform_locations.phong.tile_lights, 2);
 
         // 简单着色器
-        program_simple = load_program("shaders/simple.vert", "shaders/simple.frag");
+        program_simple = load_program("shaders/simple.vert", "shaders/simple.frag", {}, glsl_version());
         glBindAttribLocation(program_simple, 0, "position");
         glBindAttribLocation(program_simple, 2, "color");
         glLinkProgram(program_simple);
         get_simple_uniform_locations();
 
-        GLuint buffers[] = {VBO, IBO, NBO};
+        // 实例化绘制的标记球
+        program_marker = load_program("shaders/marker.vert", "shaders/simple.frag", {}, glsl_version());
+        glBindAttribLocation(program_marker, 0, "position");
+        glBindAttribLocation(program_marker, 2, "color");
+        glBindAttribLocation(program_marker, 3, "center");
+        glLinkProgram(program_marker);
+
+        // 拾取：片元着色器输出图元编号，需要 gl_PrimitiveID 与整数颜色缓冲区
+        gpu_picking = core_profile || (GLEW_VERSION_3_0 && GLEW_EXT_gpu_shader4);
+        if (gpu_picking) {
+            program_pick = load_program("shaders/pick.vert", "shaders/pick.frag", {}, glsl_version());
+            glBindAttribLocation(program_pick, 0, "position");
+            glBindFragDataLocation(program_pick, 0, "pick_id");
+            glLinkProgram(program_pick);
+            uniform_locations.pick.mvp     = glGetUniformLocation(program_pick, "mvp");
+            uniform_locations.pick.id_base = glGetUniformLocation(program_pick, "id_base");
+        }
+
+        // uniform 块
+        camera_block.create(CAMERA_BINDING, sizeof(CameraBlock));
+        lights_block.create(LIGHTS_BINDING, max_lights * sizeof(LightSource));
+        shading_block.create(SHADING_BINDING, sizeof(ShadingBlock));
+        for (GLuint program : {program_phong, program_simple, program_marker}) {
+            camera_block.attach(program, "Camera");
+        }
+        lights_block.attach(program_phong, "Lights");
+        shading_block.attach(program_phong, "Shading");
+
+        GLuint buffers[] = {VBO, IBO, NBO, marker_buffer};
         glGenBuffers(std::end(buffers) - std::begin(buffers), buffers);
-        VBO = buffers[0];
-        IBO = buffers[1];
-        NBO = buffers[2];
+        VBO           = buffers[0];
+        IBO           = buffers[1];
+        NBO           = buffers[2];
+        marker_buffer = buffers[3];
+        glGenVertexArrays(1, &upload_vao);
+
+        // 分块纹理按像素读取，不做过滤
+        glGenTextures(2, tile_textures);
+        for (GLuint texture : tile_textures) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
 
-        // 顶点缓冲区对象
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, model.vertices.size() * sizeof(GLfloat), model.vertices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // 光源基准测试的各项
+        if (bench_lights) {
+            for (size_t n = 2; n <= max_lights; n *= 2) {
+                bench_plan.push_back({n, true});
+                bench_plan.push_back({n, false});
+            }
+            apply_bench_step();
+        }
+    }
 
-        // 顶点索引缓冲区对象
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.indices.size() * sizeof(GLuint), model.indices.data(),
-                     GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    // 把后台线程已发布的模型分段追加到预先分配的缓冲区中
+    void consumeStream() {
+        if (!stream.allocated) {
+            size_t vertices, normals, indices;
+            if (!model_stream.layout(vertices, normals, indices)) {
+                return;
+            }
+            stream.vertex_capacity = vertices;
+            stream.normal_capacity = normals;
+            stream.index_capacity  = indices;
+
+            // IBO 的绑定属于当前 VAO，上传时绑定 upload_vao 以免改动绘制用的 VAO
+            gl_state.bind_vertex_array(upload_vao);
+            gl_state.bind_buffer(GL_ARRAY_BUFFER, VBO);
+            glBufferData(GL_ARRAY_BUFFER, vertices * sizeof(GLfloat), nullptr, GL_STATIC_DRAW);
+            gl_state.bind_buffer(GL_ARRAY_BUFFER, NBO);
+            glBufferData(GL_ARRAY_BUFFER, normals * sizeof(GLfloat), nullptr, GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+            stream.allocated = true;
+            model_parts      = {{0, vertices / 3, 0, indices}};
+            build_model_vaos();
+        }
+
+        for (auto &piece : model_stream.take()) {
+            const auto &data = piece.data;
+            if (piece.vertex_offset + data.vertices.size() > stream.vertex_capacity ||
+                piece.normal_offset + data.normals.size() > stream.normal_capacity ||
+                piece.index_offset + data.indices.size() > stream.index_capacity) {
+                // 与预扫描结果不符，等待完整模型
+                stream.overflow = true;
+                break;
+            }
+            gl_state.bind_vertex_array(upload_vao);
+            gl_state.bind_buffer(GL_ARRAY_BUFFER, VBO);
+            glBufferSubData(GL_ARRAY_BUFFER, piece.vertex_offset * sizeof(GLfloat),
+                            data.vertices.size() * sizeof(GLfloat), data.vertices.data());
+            gl_state.bind_buffer(GL_ARRAY_BUFFER, NBO);
+            glBufferSubData(GL_ARRAY_BUFFER, piece.normal_offset * sizeof(GLfloat),
+                            data.normals.size() * sizeof(GLfloat), data.normals.data());
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, piece.index_offset * sizeof(GLuint),
+                            data.indices.size() * sizeof(GLuint), data.indices.data());
+
+            stream.vertices += data.vertices.size();
+            stream.normals += data.normals.size();
+            stream.indices += data.indices.size();
+            stream.waiting.push_back({stream.indices, piece.max_index});
+        }
 
-        // 法向量顶点缓冲区对象
-        glBindBuffer(GL_ARRAY_BUFFER, NBO);
-        glBufferData(GL_ARRAY_BUFFER, model.normals.size() * sizeof(GLfloat), model.normals.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // 面片引用的顶点（及法向量）都已上传后才能绘制
+        while (!stream.waiting.empty()) {
+            auto [index_end, max_index] = stream.waiting.front();
+            bool vertices_ready         = max_index < stream.vertices / 3;
+            bool normals_ready          = stream.normal_capacity == 0 || max_index < stream.normals / 3;
+            if (index_end > stream.ready_indices && !(vertices_ready && normals_ready)) {
+                break;
+            }
+            stream.ready_indices = index_end;
+            stream.waiting.pop_front();
+        }
+        drawn_index_count = stream.ready_indices;
     }
 
-    void get_phong_uniform_locations() {
-        GET_PHONG_UNIFORM_LOCATION(lights[0].ambient);
-        GET_PHONG_UNIFORM_LOCATION(lights[0].diffuse);
-        GET_PHONG_UNIFORM_LOCATION(lights[0].specular);
-        GET_PHONG_UNIFORM_LOCATION(lights[0].position);
+    // 后台加载完成后上传模型数据
+    void uploadModel() {
+        load_thread.join();
+
+        // 取走剩余的分段；分段上传的是文件中的顺序，重排过或改用交错布局时需要整体重新上传
+        if (stream.allocated && !stream.overflow && !model_stream.aborted()) {
+            consumeStream();
+        }
+        bool streamed = stream.allocated && !stream.overflow && !model_stream.aborted() &&
+                        stream.vertices == model.vertices.size() && stream.normals == model.normals.size() &&
+                        stream.indices == model.indices.size() && !model_reordered && !interleaved_layout;
+        model_uploaded    = true;
+        drawn_index_count = model.indices.size();
+
+        Mesh<GLfloat, GLushort> mesh16;
+        model_parts = split_mesh_16(model, mesh16, model_lods);
+        lod_ranges  = {{0, model.indices.size()}};
+        for (const auto &lod : model_lods) {
+            lod_ranges.push_back({lod_ranges.back().first + lod_ranges.back().second, lod.size()});
+        }
+        std::vector<std::vector<GLuint>>().swap(model_lods);
+        // 只有一个子网格时顶点数据不变，分段上传的顶点仍然可用，只需替换为 16 位索引
+        gl_state.bind_vertex_array(upload_vao);
+        if (!streamed || model_parts.size() > 1) {
+            upload_vertices(mesh16);
+        }
+        upload_indices(mesh16.indices);
+        build_model_vaos();
+    }
 
-        GET_PHONG_UNIFORM_LOCATION(lights[1].ambient);
-        GET_PHONG_UNIFORM_LOCATION(lights[1].diffuse);
-        GET_PHONG_UNIFORM_LOCATION(lights[1].specular);
-        GET_PHONG_UNIFORM_LOCATION(lights[1].position);
+    // 上传顶点坐标与法向量，交错布局时合并到 VBO 中
+    template <typename index>
+    void upload_vertices(const Mesh<GLfloat, index> &mesh) {
+        // 顶点缓冲区对象
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, VBO);
+        if (interleaved_layout) {
+            auto interleaved = interleave_vertices(mesh);
+            glBufferData(GL_ARRAY_BUFFER, interleaved.size() * sizeof(InterleavedVertex), interleaved.data(),
+                         GL_STATIC_DRAW);
+            vbo_interleaved = true;
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(GLfloat), mesh.vertices.data(),
+                         GL_STATIC_DRAW);
+        }
+
+        // 法向量顶点缓冲区对象，交错布局时释放其存储
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, NBO);
+        if (vbo_interleaved) {
+            glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, mesh.normals.size() * sizeof(GLfloat), mesh.normals.data(), GL_STATIC_DRAW);
+        }
+    }
 
-        GET_PHONG_UNIFORM_LOCATION(material.ambient);
-        GET_PHONG_UNIFORM_LOCATION(material.diffuse);
-        GET_PHONG_UNIFORM_LOCATION(material.specular);
-        GET_PHONG_UNIFORM_LOCATION(material.shininess);
+    // 上传顶点索引并记录绘制时使用的索引类型，调用时须绑定 upload_vao
+    template <typename index>
+    void upload_indices(const std::pmr::vector<index> &indices) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(index), indices.data(), GL_STATIC_DRAW);
+        index_type = gl_index_type<index>;
+        index_size = sizeof(index);
+    }
 
-        GET_PHONG_UNIFORM_LOCATION(global_ambient);
+    double elapsed_ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    }
 
+    void get_phong_uniform_locations() {
+        GET_PHONG_UNIFORM_LOCATION(tile_grid);
+        GET_PHONG_UNIFORM_LOCATION(tile_lights);
         GET_PHONG_UNIFORM_LOCATION(model);
-        GET_PHONG_UNIFORM_LOCATION(view);
-        GET_PHONG_UNIFORM_LOCATION(proj);
     }
 
     void get_simple_uniform_locations() {
         GET_SIMPLE_UNIFORM_LOCATION(model);
-        GET_SIMPLE_UNIFORM_LOCATION(view);
-        GET_SIMPLE_UNIFORM_LOCATION(proj);
+    }
+
+    void parse_args() {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "--no-cache") {
+                use_mesh_cache = false;
+            } else if (arg == "--weld-epsilon" && i + 1 < argc) {
+                // 缓存不记录合并距离，指定时不读写缓存
+                weld_epsilon   = std::strtof(argv[++i], nullptr);
+                use_mesh_cache = false;
+            } else if (arg == "--no-optimize") {
+                // 缓存中保存的是优化后的结果，对比时不读写缓存
+                optimize_model = false;
+                use_mesh_cache = false;
+            } else if (arg == "--interleaved") {
+                interleaved_layout = true;
+            } else if (arg == "--no-lod") {
+                build_lods = false;
+            } else if (arg == "--markers" && i + 1 < argc) {
+                probe_count = std::max(0, std::atoi(argv[++i]));
+                draw_lights = true;
+            } else if (arg == "--bench" && i + 1 < argc) {
+                bench_frames = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--bench-lights") {
+                bench_lights = true;
+            } else if (arg == "--no-state-cache") {
+                use_state_cache = false;
+            } else if (arg == "--core") {
+                core_profile = true;
+            } else {
+                model_filename = argv[i];
+            }
+        }
+        if (bench_lights && bench_frames == 0) {
+            bench_frames = 200;
+        }
     }
 
     void loadModel() {
-        // 加载 Stanford Bunny 数据
-        const char *filename = "bunny.obj";
-        if (argc >= 2) {
-            filename = argv[1];
+        // 加载 Stanford Bunny 数据，按扩展名选择 OBJ、PLY 或 STL 格式，优先使用与模型文件匹配的二进制缓存
+        const char *filename = model_filename;
+        auto t0              = std::chrono::steady_clock::now();
+        bool from_cache      = use_mesh_cache && load_mesh_cache(filename, model);
+        VertexCacheStats before, after;
+        if (from_cache && model.normals.size() != model.vertices.size()) {
+            // 与 load_mesh 相同，缺少法向量时由三角形计算
+            generate_normals(model, &ThreadPool::global());
+        }
+        if (!from_cache) {
+            model = load_mesh(filename, &load_progress, &model_stream, weld_epsilon, &model_arena);
+            // 重排三角形顺序以提高顶点缓存命中率，再按首次使用的顺序重新编号顶点使顶点读取接近顺序访问
+            // 缓存中保存的是重排后的结果
+            before = analyze_vertex_cache(model);
+            if (optimize_model) {
+                optimize_vertex_cache(model, &ThreadPool::global());
+                optimize_vertex_fetch(model);
+                model_reordered = true;
+            }
+            if (use_mesh_cache && !save_mesh_cache(filename, model)) {
+                fprintf(stderr, "failed to write mesh cache for %s\n", filename);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        after   = analyze_vertex_cache(model);
+        if (from_cache) {
+            before = after;
+        }
+        compute_bounding_sphere();
+
+        // 划分 meshlet 用于逐帧剔除
+        model_meshlets = build_meshlets(model);
+
+        // 构建 BVH 用于拾取
+        auto t3       = std::chrono::steady_clock::now();
+        model_bvh     = build_bvh(model);
+        double bvh_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t3).count();
+
+        // 生成 LOD 链，各级与完整网格共用顶点
+        double lod_ms = 0;
+        if (build_lods) {
+            auto t2    = std::chrono::steady_clock::now();
+            model_lods = build_lod_chain(model);
+            lod_ms     = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t2).count();
         }
-        model = load_bunny_data(filename);
 
-        printf("%s loaded, vertices:%lu, faces:%lu, normals:%lu\n", filename, (unsigned long)model.vertices.size() / 3,
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        printf("%s loaded%s in %.1f ms, vertices:%lu, faces:%lu, normals:%lu\n", filename,
+               from_cache ? " from cache" : "", ms, (unsigned long)model.vertices.size() / 3,
                (unsigned long)model.indices.size() / 3, (unsigned long)model.normals.size() / 3);
+        printf("vertex cache (FIFO %u): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", VERTEX_CACHE_SIZE, before.acmr,
+               after.acmr, before.atvr, after.atvr);
+        printf("mesh memory: %lu allocations, %.1f MB reserved, %.1f MB overflow, peak RSS %.1f MB\n",
+               (unsigned long)model_arena.allocations(), model_arena.reserved_bytes() / 1e6,
+               model_arena.overflow_bytes() / 1e6, peak_rss_bytes() / 1e6);
+        printf("meshlets: %lu (up to %lu vertices, %lu faces each)\n", (unsigned long)model_meshlets.size(),
+               (unsigned long)MESHLET_MAX_VERTICES, (unsigned long)MESHLET_MAX_TRIANGLES);
+        printf("BVH: %lu nodes built in %.1f ms\n", (unsigned long)model_bvh.nodes.size(), bvh_ms);
+        if (!model_lods.empty()) {
+            printf("LOD chain built in %.1f ms, faces:", lod_ms);
+            for (const auto &lod : model_lods) {
+                printf(" %lu", (unsigned long)lod.size() / 3);
+            }
+            printf("\n");
+        }
+    }
+
+    // 模型坐标系中的包围球：取包围盒中心及到各顶点的最大距离
+    void compute_bounding_sphere() {
+        if (model.vertices.empty()) {
+            return;
+        }
+        GLfloat lo[3], hi[3];
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = hi[a] = model.vertices[a];
+        }
+        for (size_t i = 0; i < model.vertices.size(); i += 3) {
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = std::min(lo[a], model.vertices[i + a]);
+                hi[a] = std::max(hi[a], model.vertices[i + a]);
+            }
+        }
+        for (int a = 0; a < 3; ++a) {
+            model_center[a] = (lo[a] + hi[a]) * 0.5f;
+        }
+        GLfloat r2 = 0.0f;
+        for (size_t i = 0; i < model.vertices.size(); i += 3) {
+            glm::vec3 d = glm::make_vec3(model.vertices.data() + i) - glm::make_vec3(model_center);
+            r2          = std::max(r2, glm::dot(d, d));
+        }
+        model_radius = std::sqrt(r2);
+    }
+
+    // 由包围球的投影直径（像素）选择 LOD 级别：三角形数约与投影面积成正比，
+    // 第 l 级在投影直径小于 LOD_FULL_PIXELS 乘以其三角形比例的平方根时使用
+    // 滞后：当前级别在投影直径放大、缩小 lod_hysteresis 倍所对应的两个级别之间时保持不变
+    void update_lod() {
+        if (lod_ranges.size() <= 1) {
+            lod_level = 0;
+            return;
+        }
+        if (!auto_lod) {
+            lod_level = std::min<size_t>(forced_lod, lod_ranges.size() - 1);
+            return;
+        }
+        glm::vec3 center = mat_model * glm::vec4(glm::make_vec3(model_center), 1.0f);
+        float distance   = glm::length(eye_position - center);
+        projected_pixels = distance > model_radius
+                               ? viewport.h * model_radius / (distance * std::tan(glm::radians(fovy) * 0.5f))
+                               : std::numeric_limits<float>::infinity();
+
+        auto level_for = [&](float pixels) {
+            size_t level = 0;
+            while (level + 1 < lod_ranges.size()) {
+                float ratio = float(lod_ranges[level + 1].second) / lod_ranges[0].second;
+                if (pixels >= LOD_FULL_PIXELS * std::sqrt(ratio)) {
+                    break;
+                }
+                ++level;
+            }
+            return level;
+        };
+        size_t finest   = level_for(projected_pixels * (1.0f + lod_hysteresis));
+        size_t coarsest = level_for(projected_pixels * (1.0f - lod_hysteresis));
+        lod_level       = std::clamp(lod_level, finest, coarsest);
+    }
+
+    // 绘制模型时使用的索引范围：上传完成后为当前 LOD 级别，加载过程中为已就绪的部分
+    std::pair<size_t, size_t> model_index_range() const {
+        if (lod_level < lod_ranges.size()) {
+            return lod_ranges[lod_level];
+        }
+        return {0, size_t(drawn_index_count)};
     }
 
     // 设置模型姿态
@@ -317,8 +808,9 @@ private:
         mat_model = glm::translate(mat_model, glm::vec3{0.0f, -0.5f, 0.0f});
     }
 
-    void model_transform() {
-        glMultMatrixf(glm::value_ptr(mat_model));
+    // core profile 按 GLSL 3.30 编译着色器，否则沿用着色器文件中的 #version 120
+    const char *glsl_version() const {
+        return core_profile ? "#version 330 core" : "";
     }
 
     void initImgui() {
@@ -332,21 +824,39 @@ private:
 
         // Setup Platform/Renderer bindings
         ImGui_ImplGlfw_InitForOpenGL(window, true);
-        ImGui_ImplOpenGL3_Init();
+        ImGui_ImplOpenGL3_Init(core_profile ? "#version 330 core" : nullptr);
     }
 
     void cleanup() {
+        // 窗口关闭时模型可能仍在加载
+        if (load_thread.joinable()) {
+            load_thread.join();
+        }
+
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
-        const GLuint buffers[] = {VBO, IBO, NBO};
+        const GLuint buffers[] = {VBO, IBO, NBO, marker_buffer};
         glDeleteBuffers(std::end(buffers) - std::begin(buffers), buffers);
+        glDeleteTextures(2, tile_textures);
+        glDeleteVertexArrays(model_vaos.size(), model_vaos.data());
+        glDeleteVertexArrays(1, &marker_vao);
+        glDeleteVertexArrays(1, &upload_vao);
+        camera_block.release();
+        lights_block.release();
+        shading_block.release();
+        geometry.release();
+        pick_buffer.release();
 
         // 清除程序对象和 shader 对象
         glUseProgram(0);
         cleanup_program(program_simple);
+        cleanup_program(program_marker);
         cleanup_program(program_phong);
+        if (program_pick) {
+            cleanup_program(program_pick);
+        }
 
         glfwDestroyWindow(window);
         glfwTerminate();
@@ -360,190 +870,336 @@ private:
         glDeleteShader(shaders[1]);
     }
 
-    // 光源及材质设置
-    void set_phong_uniform() {
-        glUseProgram(program_phong);
-        // 0 号光源
-        SET_PHONG_UNIFORM4(lights[0].ambient);
-        SET_PHONG_UNIFORM4(lights[0].diffuse);
-        SET_PHONG_UNIFORM4(lights[0].specular);
-        SET_PHONG_UNIFORM4(lights[0].position);
-        // 1 号光源
-        SET_PHONG_UNIFORM4(lights[1].ambient);
-        SET_PHONG_UNIFORM4(lights[1].diffuse);
-        SET_PHONG_UNIFORM4(lights[1].specular);
-        SET_PHONG_UNIFORM4(lights[1].position);
-        // 全局环境光
-        SET_PHONG_UNIFORM4(global_ambient);
-
-        // 材质设置
-        SET_PHONG_UNIFORM4(material.ambient);
-        SET_PHONG_UNIFORM4(material.diffuse);
-        SET_PHONG_UNIFORM4(material.specular);
-        SET_PHONG_UNIFORM1(material.shininess);
-
-        SET_PHONG_UNIFORM_MAT4(model);
-        SET_PHONG_UNIFORM_MAT4(view);
-        SET_PHONG_UNIFORM_MAT4(proj);
+    // 开启分块剔除时在 CPU 上求出各分块的光源列表并上传为纹理
+    // 光源、观察与投影矩阵及视口都未变化时沿用上次的结果
+    void update_light_tiles(bool scene_changed) {
+        if (!tiled_lighting) {
+            tiles_used = false;
+            return;
+        }
+        bool viewport_changed = !std::equal(std::begin(framebuffer_viewport), std::end(framebuffer_viewport),
+                                            std::begin(tiles_viewport));
+        if (tiles_used && !scene_changed && !viewport_changed) {
+            return;
+        }
+        std::copy(std::begin(framebuffer_viewport), std::end(framebuffer_viewport), std::begin(tiles_viewport));
+
+        // 在绘制线程中串行计算：加载线程会长时间占用共享线程池，分块与光源都不多，串行的开销很小
+        glm::mat4 view_proj = mat_proj * mat_view;
+        cull_light_tiles(lights, glm::value_ptr(view_proj), framebuffer_viewport[2], framebuffer_viewport[3],
+                         light_tiles);
+        // 光源编号过多、超出纹理尺寸时退回逐个遍历
+        tile_rows  = light_tiles.indices.size() / LIGHT_LIST_WIDTH;
+        tiles_used = light_tiles.tiles_x > 0 && light_tiles.tiles_y > 0 && tile_rows <= max_texture_size;
+        if (!tiles_used) {
+            return;
+        }
+        glActiveTexture(GL_TEXTURE1);
+        counted_gl(glBindTexture, GL_TEXTURE_2D, tile_textures[0]);
+        counted_gl(glTexImage2D, GL_TEXTURE_2D, 0, GL_RG32F, light_tiles.tiles_x, light_tiles.tiles_y, 0, GL_RG,
+                   GL_FLOAT, light_tiles.grid.data());
+        glActiveTexture(GL_TEXTURE2);
+        counted_gl(glBindTexture, GL_TEXTURE_2D, tile_textures[1]);
+        counted_gl(glTexImage2D, GL_TEXTURE_2D, 0, GL_R32F, LIGHT_LIST_WIDTH, tile_rows, 0, GL_RED, GL_FLOAT,
+                   light_tiles.indices.data());
+        glActiveTexture(GL_TEXTURE0);
     }
 
-    void set_simple_uniform() {
-        glUseProgram(program_simple);
-        SET_SIMPLE_UNIFORM_MAT4(view);
-        SET_SIMPLE_UNIFORM_MAT4(proj);
+    // 更新各 uniform 块，内容与上次上传的相同时不上传；phong 程序的模型矩阵变化时才设置
+    void update_uniforms() {
+        CameraBlock camera;
+        std::copy_n(glm::value_ptr(mat_view), 16, camera.view);
+        std::copy_n(glm::value_ptr(mat_proj), 16, camera.proj);
+        bool camera_changed = camera_block.update(&camera, sizeof(camera));
+        bool lights_changed = lights_block.update(lights.data(), lights.size() * sizeof(LightSource));
+        update_light_tiles(camera_changed || lights_changed);
+
+        ShadingBlock shading = {};
+        std::copy_n(material.ambient, 4, shading.ambient);
+        std::copy_n(material.diffuse, 4, shading.diffuse);
+        std::copy_n(material.specular, 4, shading.specular);
+        shading.shininess = material.shininess;
+        std::copy_n(global_ambient, 4, shading.global_ambient);
+        shading.light_count = lights.size();
+        shading.use_tiles   = tiles_used;
+        if (tiles_used) {
+            shading.tile_params[0] = tiles_viewport[0];
+            shading.tile_params[1] = tiles_viewport[1];
+            shading.tile_params[2] = LIGHT_TILE_SIZE;
+            shading.tile_params[3] = LIGHT_LIST_WIDTH;
+            shading.tile_counts[0] = light_tiles.tiles_x;
+            shading.tile_counts[1] = light_tiles.tiles_y;
+            shading.tile_rows      = tile_rows;
+        }
+        shading_block.update(&shading, sizeof(shading));
+
+        if (phong_model != mat_model) {
+            gl_state.use_program(program_phong);
+            SET_PHONG_UNIFORM_MAT4(model);
+            phong_model = mat_model;
+        }
     }
 
-    // 渲染模型
-    void draw_model() {
+    // 在当前绑定的 VAO 中把模型从 first_vertex 开始的顶点坐标设为 0 号属性、法向量设为 1 号属性
+    // GL 2.1 没有 glDrawElementsBaseVertex，子网格的顶点偏移通过属性指针的字节偏移实现
+    void bind_model_attributes(size_t first_vertex) {
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, VBO);
         glEnableVertexAttribArray(0);
         glEnableVertexAttribArray(1);
-        glUseProgram(program_phong);
+        if (vbo_interleaved) {
+            constexpr GLsizei stride = sizeof(InterleavedVertex);
+            size_t base              = first_vertex * stride;
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+                                  reinterpret_cast<const void *>(base + offsetof(InterleavedVertex, position)));
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                                  reinterpret_cast<const void *>(base + offsetof(InterleavedVertex, normal)));
+            return;
+        }
+        const void *base = reinterpret_cast<const void *>(first_vertex * 3 * sizeof(GLfloat));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, base);
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, NBO);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, base);
+    }
 
-        // 顶点坐标
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    // 为每个子网格重建一个 VAO，记录其顶点偏移下的属性指针与 IBO；缓冲区布局或子网格变化后调用
+    // 绘制线框等不使用法向量的程序时 1 号属性虽然启用但不被读取，颜色（2 号属性）始终取 glVertexAttrib 设置的当前值
+    void build_model_vaos() {
+        gl_state.bind_vertex_array(0);
+        glDeleteVertexArrays(model_vaos.size(), model_vaos.data());
+        model_vaos.resize(model_parts.size());
+        glGenVertexArrays(model_vaos.size(), model_vaos.data());
+        for (size_t p = 0; p < model_parts.size(); ++p) {
+            gl_state.bind_vertex_array(model_vaos[p]);
+            bind_model_attributes(model_parts[p].first_vertex);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+        }
+        gl_state.bind_vertex_array(0);
+    }
 
-        // 法向量
-        glBindBuffer(GL_ARRAY_BUFFER, NBO);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    // 绘制 IBO 中若干 (起始位置, 索引个数) 区间内的三角形
+    // 按所在子网格切换 VAO，每个子网格用一次 glMultiDrawElements 绘制与之相交的全部区间
+    void draw_model_ranges(const std::vector<std::pair<size_t, size_t>> &ranges) {
+        for (size_t p = 0; p < model_parts.size(); ++p) {
+            const auto &part = model_parts[p];
+            multi_counts.clear();
+            multi_offsets.clear();
+            for (auto [first, count] : ranges) {
+                size_t begin = std::max(first, part.first_index);
+                size_t end   = std::min(first + count, part.first_index + part.index_count);
+                if (begin < end) {
+                    multi_counts.push_back(end - begin);
+                    // 使用 IBO 时，偏移表示 IBO 中以字节为单位的位置
+                    multi_offsets.push_back(reinterpret_cast<const void *>(begin * index_size));
+                }
+            }
+            if (multi_counts.empty()) {
+                continue;
+            }
+            gl_state.bind_vertex_array(model_vaos[p]);
+            glMultiDrawElements(GL_TRIANGLES, multi_counts.data(), index_type, multi_offsets.data(),
+                                multi_counts.size());
+        }
+    }
 
-        // 顶点索引
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    // 绘制 IBO 中 [first, first + count) 范围内的三角形
+    void draw_model_elements(size_t first, size_t count) {
+        single_range[0] = {first, count};
+        draw_model_ranges(single_range);
+    }
 
-        glDrawElements(GL_TRIANGLES, model.indices.size(), GL_UNSIGNED_INT, nullptr);
+    // 在模型坐标系中剔除 meshlet，结果写入 visible_ranges 与 cull_stats
+    void cull_model() {
+        CullView view;
+        // 从 MVP 矩阵的行提取视锥体的六个平面（glm 按列存储，m[c][r] 为第 r 行第 c 列）
+        glm::mat4 mvp = mat_proj * mat_view * mat_model;
+        for (int i = 0; i < 3; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                view.planes[i * 2][c]     = mvp[c][3] + mvp[c][i];
+                view.planes[i * 2 + 1][c] = mvp[c][3] - mvp[c][i];
+            }
+        }
+        glm::vec4 eye = glm::inverse(mat_model) * glm::vec4(eye_position, 1.0f);
+        view.eye[0]   = eye.x;
+        view.eye[1]   = eye.y;
+        view.eye[2]   = eye.z;
+        cull_stats    = cull_meshlets(model_meshlets, view, visible_ranges, &ThreadPool::global());
+    }
+
+    // 渲染模型
+    void draw_model() {
+        gl_state.use_program(program_phong);
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
 
-        glDisableVertexAttribArray(0);
-        glDisableVertexAttribArray(1);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        // 绘制完整网格时只绘制剔除后可见的 meshlet
+        if (meshlet_culling && model_uploaded && lod_level == 0 && !model_meshlets.empty()) {
+            cull_model();
+            draw_model_ranges(visible_ranges);
+        } else {
+            auto [first, count] = model_index_range();
+            draw_model_elements(first, count);
+        }
     }
 
     // 画坐标轴
-    // TODO: 使用顶点缓存
     void draw_coordinate() {
-        glEnableVertexAttribArray(0);
-        glDisableVertexAttribArray(2);
-        glUseProgram(program_simple);
+        gl_state.use_program(program_simple);
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
         glUniformMatrix4fv(uniform_locations.simple.model, 1, GL_FALSE, glm::value_ptr(glm::identity<glm::mat4>()));
 
-        const static GLfloat coord_lines[][3] = {
-            {10.0, 0.0, 0.0},  {-10.0, 0.0, 0.0}, {10.0, 1.0, 0.0},   {-10.0, 1.0, 0.0}, {10.0, 0.0, 1.0},
-            {-10.0, 0.0, 1.0}, {10.0, -1.0, 0.0}, {-10.0, -1.0, 0.0}, {10.0, 0.0, -1.0}, {-10.0, 0.0, -1.0},
-            {0.0, 10.0, 0.0},  {0.0, -10.0, 0.0}, {1.0, 10.0, 0.0},   {1.0, -10.0, 0.0}, {0.0, 10.0, 1.0},
-            {0.0, -10.0, 1.0}, {-1.0, 10.0, 0.0}, {-1.0, -10.0, 0.0}, {0.0, 10.0, -1.0}, {0.0, -10.0, -1.0},
-            {0.0, 0.0, 10.0},  {0.0, 0.0, -10.0}, {1.0, 0.0, 10.0},   {1.0, 0.0, -10.0}, {0.0, 1.0, 10.0},
-            {0.0, 1.0, -10.0}, {-1.0, 0.0, 10.0}, {-1.0, 0.0, -10.0}, {0.0, -1.0, 10.0}, {0.0, -1.0, -10.0},
-        };
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, coord_lines);
-
+        const GpuMesh &lines = geometry.coordinate_lines();
+        gl_state.bind_vertex_array(lines.vao);
         glVertexAttrib3f(2, 0.f, 0.f, 0.f);
 
-        glDrawArrays(GL_LINES, 0, sizeof(coord_lines) / sizeof(GLfloat) / 3);
-
-        glDisableVertexAttribArray(0);
+        counted_gl(glDrawArrays, GL_LINES, 0, lines.vertex_count);
     }
 
     // 绘制模型线框
+    // 模型的 VAO 不启用 2 号属性，颜色由 glVertexAttrib 给出
+    // core profile 只能同时设置正反面的多边形模式；不显示背面线框时背面已被剔除，效果相同
     void draw_wire_model() {
-        glEnableVertexAttribArray(0);
-        // 需要禁用索引为 2 的顶点属性数组，否则绘制函数会认为
-        // 定点属性数据被 glVertexAttribPointer 指定，而 glVertexAttrib 无用
-        glDisableVertexAttribArray(2);
-        glPolygonMode(GL_FRONT, GL_LINE);
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_LINE);
         if (show_back_wire) {
-            glDisable(GL_CULL_FACE);
-            glPolygonMode(GL_BACK, GL_LINE);
+            counted_gl(glDisable, GL_CULL_FACE);
         }
-        glUseProgram(program_simple);
+        gl_state.use_program(program_simple);
         SET_SIMPLE_UNIFORM_MAT4(model);
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-
         glVertexAttrib4fv(2, wire_color);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-
-        glDrawElements(GL_TRIANGLES, model.indices.size(), GL_UNSIGNED_INT, nullptr);
+        auto [first, count] = model_index_range();
+        draw_model_elements(first, count);
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glDisableVertexAttribArray(0);
-        glPolygonMode(GL_FRONT, GL_FILL);
         if (show_back_wire) {
-            glEnable(GL_CULL_FACE);
-            glPolygonMode(GL_BACK, GL_FILL);
+            counted_gl(glEnable, GL_CULL_FACE);
         }
     }
 
-    // 在光源位置绘制小球
-    // TODO: 绘制光球效果
-    void draw_light_balls() {
-        glEnableVertexAttribArray(0);
-        glDisableVertexAttribArray(2);
-        glUseProgram(program_simple);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-        auto mesh = genSolidSphere(0.05, 16, 16);
-
-        auto draw_light = [&](size_t i) {
-            glm::mat4 m = glm::translate(glm::identity<glm::mat4>(), glm::make_vec3(lights[i].position));
-            glUniformMatrix4fv(uniform_locations.simple.model, 1, GL_FALSE, glm::value_ptr(m));
-            glVertexAttrib4fv(2, lights[i].diffuse);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, mesh.vertices.data());
-            glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, mesh.indices.data());
-        };
+    // 用缓存的单位球绘制半径为 radius、模型矩阵为 m 的小球，颜色由 2 号属性的当前值给出
+    void draw_sphere(const GpuMesh &sphere, const glm::mat4 &m, GLfloat radius) {
+        glm::mat4 scaled = glm::scale(m, glm::vec3(radius));
+        glUniformMatrix4fv(uniform_locations.simple.model, 1, GL_FALSE, glm::value_ptr(scaled));
+        counted_gl(glDrawElements, GL_TRIANGLES, sphere.index_count, sphere.index_type, nullptr);
+    }
+
+    // 在半径为 3 的球面上按黄金角螺旋均匀放置 count 个探针标记，颜色随方向变化
+    void generate_probe_markers(size_t count) {
+        constexpr GLfloat GOLDEN_ANGLE = 2.39996323f;
+        probe_markers.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            GLfloat z   = 1.0f - 2.0f * (i + 0.5f) / count;
+            GLfloat r   = std::sqrt(1.0f - z * z);
+            GLfloat phi = GOLDEN_ANGLE * i;
+            GLfloat x = r * std::cos(phi), y = r * std::sin(phi);
+            probe_markers[i] = {{3.0f * x, 3.0f * y, 3.0f * z, 0.02f},
+                                {0.5f + 0.5f * x, 0.5f + 0.5f * y, 0.5f + 0.5f * z, 1.0f}};
+        }
+    }
 
-        for (size_t i = 0; i < LIGHTS; ++i) {
-            draw_light(i);
+    // 收集光源与探针的标记，与上次上传的内容不同时更新实例缓冲区
+    void update_marker_instances() {
+        if (probe_markers.size() != size_t(probe_count)) {
+            generate_probe_markers(probe_count);
         }
+        marker_instances.clear();
+        for (const auto &light : lights) {
+            const auto &p = light.position;
+            marker_instances.push_back({{p[0], p[1], p[2], 0.05f}, {}});
+            std::copy_n(light.diffuse, 4, marker_instances.back().color);
+        }
+        marker_instances.insert(marker_instances.end(), probe_markers.begin(), probe_markers.end());
+
+        bool changed = marker_instances.size() != uploaded_markers.size() ||
+                       std::memcmp(marker_instances.data(), uploaded_markers.data(),
+                                   marker_instances.size() * sizeof(MarkerInstance)) != 0;
+        if (changed) {
+            gl_state.bind_buffer(GL_ARRAY_BUFFER, marker_buffer);
+            glBufferData(GL_ARRAY_BUFFER, marker_instances.size() * sizeof(MarkerInstance), marker_instances.data(),
+                         GL_DYNAMIC_DRAW);
+            uploaded_markers = marker_instances;
+        }
+    }
 
-        glDisableVertexAttribArray(0);
+    // 实例化绘制标记球的 VAO：0 号属性为球的顶点坐标，2、3 号属性为每个实例前进一次的颜色与球心
+    void build_marker_vao(const GpuMesh &sphere) {
+        glGenVertexArrays(1, &marker_vao);
+        gl_state.bind_vertex_array(marker_vao);
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, sphere.vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere.ibo);
+
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, marker_buffer);
+        glEnableVertexAttribArray(2);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(MarkerInstance),
+                              reinterpret_cast<const void *>(offsetof(MarkerInstance, color)));
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(MarkerInstance),
+                              reinterpret_cast<const void *>(offsetof(MarkerInstance, center)));
+        for (GLuint attribute : {2, 3}) {
+            if (core_profile) {
+                glVertexAttribDivisor(attribute, 1);
+            } else {
+                glVertexAttribDivisorARB(attribute, 1);
+            }
+        }
+    }
+
+    // 在光源及探针位置绘制小球
+    // 支持 ARB_instanced_arrays 时一次实例化绘制全部标记，否则逐个绘制
+    // TODO: 绘制光球效果
+    void draw_light_balls() {
+        update_marker_instances();
+        const GpuMesh &sphere = geometry.sphere<16, 16>();
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
+
+        if (!instanced_markers) {
+            gl_state.use_program(program_simple);
+            gl_state.bind_vertex_array(sphere.vao);
+            for (const auto &marker : marker_instances) {
+                glm::mat4 m = glm::translate(glm::identity<glm::mat4>(), glm::make_vec3(marker.center));
+                glVertexAttrib4fv(2, marker.color);
+                draw_sphere(sphere, m, marker.center[3]);
+            }
+        } else {
+            if (!marker_vao) {
+                build_marker_vao(sphere);
+            }
+            gl_state.use_program(program_marker);
+            gl_state.bind_vertex_array(marker_vao);
+            if (core_profile) {
+                glDrawElementsInstanced(GL_TRIANGLES, sphere.index_count, sphere.index_type, nullptr,
+                                        marker_instances.size());
+            } else {
+                glDrawElementsInstancedARB(GL_TRIANGLES, sphere.index_count, sphere.index_type, nullptr,
+                                           marker_instances.size());
+            }
+        }
     }
 
     // 强调被选中的顶点
     // TODO: 在 shader 中使用 gl_PointSize 和 gl_PointCoord 绘制圆点
     void draw_selected_vertex() {
-        glEnableVertexAttribArray(0);
-        glDisableVertexAttribArray(2);
-        glUseProgram(program_simple);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gl_state.use_program(program_simple);
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
         glVertexAttrib3f(2, 0.0, 0.0, 0.0);
 
-        auto mesh = genSolidSphere(0.01, 10, 10);
+        const GpuMesh &sphere = geometry.sphere<10, 10>();
+        gl_state.bind_vertex_array(sphere.vao);
 
         glm::mat4 m = glm::translate(mat_model, glm::make_vec3(model.vertices.data() + selected_id));
-        glUniformMatrix4fv(uniform_locations.simple.model, 1, GL_FALSE, glm::value_ptr(m));
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, mesh.vertices.data());
-        glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, mesh.indices.data());
-
-        glDisableVertexAttribArray(0);
+        draw_sphere(sphere, m, 0.01f);
     }
 
     // 绘制被点选的面片
     void draw_selected_face() {
-        glEnableVertexAttribArray(0);
-        glDisableVertexAttribArray(2);
-        glUseProgram(program_simple);
+        gl_state.use_program(program_simple);
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
         SET_SIMPLE_UNIFORM_MAT4(model);
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-
         glVertexAttrib3f(2, 0.f, 0.f, 0.f);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-
-        // 使用 IBO 时，最后参数表示 IBO 中以字节为单位的偏移
-        glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, reinterpret_cast<const void *>(selected_id * sizeof(GLuint)));
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glDisableVertexAttribArray(0);
+        // 切分为子网格后三角形顺序不变，selected_id 仍是该面片在 IBO 中的索引位置
+        draw_model_elements(selected_id, 3);
     }
 
     // 更新状态
@@ -602,79 +1258,109 @@ private:
 
         glm::vec3 up = glm::cross(eye, {1.0f, 0.0f, -1.0f});
 
-        mat_view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), up);
-        glMultMatrixf(glm::value_ptr(mat_view));
+        eye_position = eye;
+        mat_view     = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), up);
     }
 
-    // 执行选取
-    // TODO: 使用软件实现
+    // 执行选取，ID 缓冲拾取不可用时在 CPU 上拾取
     void do_select() {
+        if (pick_engine == PICK_ID_BUFFER && gpu_picking) {
+            select_id_buffer();
+        } else {
+            select_bvh();
+        }
+    }
+
+    // 在 CPU 上拾取，不调用 OpenGL：把鼠标位置反投影为射线，变换到模型坐标系后在 BVH 中求最近的相交三角形
+    // 选择顶点时取该三角形投影到屏幕上离鼠标最近、且距离不超过 select_radius 的顶点
+    void select_bvh() {
         ImGuiIO &io = ImGui::GetIO();
-        glUseProgram(0);
-        glSelectBuffer(SELECT_BUF_SIZE, select_buffer);
-        glRenderMode(GL_SELECT);
+        auto t0     = std::chrono::steady_clock::now();
+        glm::vec4 vp(viewport.x, viewport.y, viewport.w, viewport.h);
+        glm::vec3 win(lb_press_pos.x, io.DisplaySize.y - lb_press_pos.y, 0.0f);
+        glm::vec3 near_point = glm::unProject(win, mat_view, mat_proj, vp);
+        win.z                = 1.0f;
+        glm::vec3 far_point  = glm::unProject(win, mat_view, mat_proj, vp);
+
+        glm::mat4 inv_model = glm::inverse(mat_model);
+        glm::vec3 origin    = glm::vec3(inv_model * glm::vec4(near_point, 1.0f));
+        glm::vec3 direction = glm::vec3(inv_model * glm::vec4(far_point, 1.0f)) - origin;
+        RayHit hit;
+        if (!intersect_bvh(model_bvh, model, glm::value_ptr(origin), glm::value_ptr(direction), hit)) {
+            return;
+        }
 
-        glMatrixMode(GL_PROJECTION);
-        glPushMatrix();
+        if (select_mode == SELECT_FACE) {
+            selected_id = hit.triangle * 3;
+        } else {
+            glm::mat4 model_view = mat_view * mat_model;
+            float best           = float(select_radius * select_radius);
+            GLint best_id        = -1;
+            for (int c = 0; c < 3; ++c) {
+                GLint id         = model.indices[hit.triangle * 3 + c] * 3;
+                glm::vec3 screen = glm::project(glm::make_vec3(model.vertices.data() + id), model_view, mat_proj, vp);
+                float dx = screen.x - win.x, dy = screen.y - win.y;
+                if (dx * dx + dy * dy <= best) {
+                    best    = dx * dx + dy * dy;
+                    best_id = id;
+                }
+            }
+            if (best_id < 0) {
+                return;
+            }
+            selected_id = best_id;
+        }
+        pick_sucess = true;
+        double us   = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        printf("selected id: %d (BVH, %.1f us)\n", selected_id, us);
+    }
 
+    // 把拾取矩形内的图元编号绘制到 pick_buffer 中，结果由下一帧的 resolve_select 取出
+    // 选择顶点时按 GL_POINTS 绘制各三角形的索引，图元编号即索引在 IBO 中的位置；选择面片时编号为三角形的序号
+    // 与先前的选择模式相同，不剔除背面，取拾取矩形内深度最小的图元
+    void select_id_buffer() {
+        ImGuiIO &io = ImGui::GetIO();
         glm::mat4 proj = glm::pickMatrix(glm::vec2(lb_press_pos.x, io.DisplaySize.y - lb_press_pos.y),
                                          glm::vec2(select_radius * 2, select_radius * 2),
                                          glm::vec4(viewport.x, viewport.y, viewport.w, viewport.h));
         proj *= glm::perspective(glm::radians(fovy), 1.0f, 0.1f, 20.0f);
-        glLoadMatrixf(glm::value_ptr(proj));
-
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadIdentity();
-        set_lookat();
-
-        // 绘制模型
-        switch (select_mode) {
-        case SELECT_VERTEX:
-            draw_model_select_vertex();
-            break;
-        case SELECT_FACE:
-            draw_model_select_face();
-            break;
-        }
-
-        // 恢复先前矩阵
-        glMatrixMode(GL_MODELVIEW);
-        glPopMatrix();
-        glMatrixMode(GL_PROJECTION);
-        glPopMatrix();
-
-        // 回到渲染模式并得到选中物体的数目
-        GLint hits = glRenderMode(GL_RENDER);
-        printf("hits: %d\n", hits);
-        if (hits >= 1) {
-            GLuint minz = select_buffer[1];
-            selected_id = select_buffer[3];
-            size_t i    = 0;
-            for (GLint n = 0; n < hits; ++n) {
-                if (select_buffer[i] == 0) {
-                    printf("name: <None>\n");
-                    printf("min z: %u\n", select_buffer[i + 1]);
-                    printf("max z: %u\n", select_buffer[i + 2]);
-                    i += 3;
-                } else {
-                    printf("name: ");
-                    for (GLuint m = i + 3; m < i + 3 + select_buffer[i]; ++m) {
-                        printf("%u ", select_buffer[m]);
-                    }
-                    printf("\n");
-                    printf("min z: %u\n", select_buffer[i + 1]);
-                    printf("max z: %u\n", select_buffer[i + 2]);
-                    if (select_buffer[i + 1] < minz) {
-                        minz        = select_buffer[i + 1];
-                        selected_id = select_buffer[i + 3];
-                    }
-                    i += 3 + select_buffer[i];
-                }
+        glm::mat4 mvp = proj * mat_view * mat_model;
+
+        // 拾取矩形按实际像素绘制
+        GLsizei side = std::max<GLsizei>(1, GLsizei(std::ceil(select_radius * 2 * io.DisplayFramebufferScale.x)));
+        pick_buffer.begin(side);
+        gl_state.use_program(program_pick);
+        gl_state.polygon_mode(GL_FRONT_AND_BACK, GL_FILL);
+        glUniformMatrix4fv(uniform_locations.pick.mvp, 1, GL_FALSE, glm::value_ptr(mvp));
+
+        // 只绘制完整网格；每个子网格一次绘制，id_base 为其第一个图元的编号
+        GLenum mode = select_mode == SELECT_VERTEX ? GL_POINTS : GL_TRIANGLES;
+        for (size_t p = 0; p < model_parts.size(); ++p) {
+            const auto &part = model_parts[p];
+            size_t end       = std::min(part.first_index + part.index_count, model.indices.size());
+            if (part.first_index >= end) {
+                continue;
             }
-            pick_sucess = true;
-            printf("selected id: %d\n", selected_id);
+            glUniform1i(uniform_locations.pick.id_base,
+                        GLint(mode == GL_POINTS ? part.first_index : part.first_index / 3));
+            gl_state.bind_vertex_array(model_vaos[p]);
+            counted_gl(glDrawElements, mode, end - part.first_index, index_type,
+                       reinterpret_cast<const void *>(part.first_index * index_size));
+        }
+        pick_buffer.end(framebuffer_viewport);
+        pick_mode = select_mode;
+    }
+
+    // 取出上一帧的拾取结果；选择模式已改变时丢弃
+    void resolve_select() {
+        GLuint id;
+        if (!pick_buffer.resolve(id) || pick_mode != select_mode) {
+            return;
         }
+        // selected_id 为顶点在 vertices 中的位置或面片在 indices 中的位置
+        selected_id = select_mode == SELECT_VERTEX ? model.indices[id] * 3 : id * 3;
+        pick_sucess = true;
+        printf("selected id: %d\n", selected_id);
     }
 
     // UI 设计代码
@@ -691,6 +1377,11 @@ private:
                 ImGui::SliderFloat("fovy", &fovy, 0.1f, 90.0f);
                 ImGui::Checkbox("draw coordinate", &draw_coord);
                 ImGui::Checkbox("draw lights", &draw_lights);
+                if (draw_lights) {
+                    ImGui::TreePush();
+                    ImGui::SliderInt("probe markers", &probe_count, 0, 10000);
+                    ImGui::TreePop();
+                }
                 ImGui::Checkbox("wire view", &enable_wire_view);
                 if (enable_wire_view) {
                     ImGui::TreePush();
@@ -698,6 +1389,19 @@ private:
                     ImGui::ColorEdit3("wire color", wire_color);
                     ImGui::TreePop();
                 }
+                if (!model_meshlets.empty()) {
+                    ImGui::Checkbox("meshlet culling", &meshlet_culling);
+                }
+                if (lod_ranges.size() > 1) {
+                    ImGui::Checkbox("auto LOD", &auto_lod);
+                    ImGui::TreePush();
+                    if (auto_lod) {
+                        ImGui::SliderFloat("hysteresis", &lod_hysteresis, 0.0f, 0.5f);
+                    } else {
+                        ImGui::SliderInt("LOD level", &forced_lod, 0, lod_ranges.size() - 1);
+                    }
+                    ImGui::TreePop();
+                }
                 ImGui::Separator();
                 ImGui::Text("Select Mode");
                 ImGui::RadioButton("None", &select_mode, SELECT_NONE);
@@ -705,6 +1409,11 @@ private:
                 ImGui::RadioButton("Vertex", &select_mode, SELECT_VERTEX);
                 ImGui::SameLine();
                 ImGui::RadioButton("Face", &select_mode, SELECT_FACE);
+                if (gpu_picking) {
+                    ImGui::RadioButton("CPU BVH", &pick_engine, PICK_BVH);
+                    ImGui::SameLine();
+                    ImGui::RadioButton("GPU ID buffer", &pick_engine, PICK_ID_BUFFER);
+                }
                 {
                     char current_radius[32];
                     static int radius_i = select_radius * 2;
@@ -742,19 +1451,45 @@ private:
                 }
                 ImGui::EndTabItem();
             }
-            for (size_t i = 0; i < LIGHTS; ++i) {
-                char light_tabname[10];
-                sprintf(light_tabname, "Light%lu", i);
-                if (ImGui::BeginTabItem(light_tabname)) {
-                    ImGui::ColorEdit4("ambient", lights[i].ambient);
-                    ImGui::ColorEdit4("diffuse", lights[i].diffuse);
-                    ImGui::ColorEdit4("specular", lights[i].specular);
-                    ImGui::Text("position:");
-                    ImGui::SliderFloat("x", &lights[i].position[0], -5.0f, 5.0f);
-                    ImGui::SliderFloat("y", &lights[i].position[1], -5.0f, 5.0f);
-                    ImGui::SliderFloat("z", &lights[i].position[2], -5.0f, 5.0f);
-                    ImGui::EndTabItem();
+            if (ImGui::BeginTabItem("Lights")) {
+                ImGui::Checkbox("tiled culling", &tiled_lighting);
+                ImGui::Text("%lu / %lu lights", (unsigned long)lights.size(), (unsigned long)max_lights);
+                if (ImGui::Button("add") && lights.size() < max_lights) {
+                    lights.push_back({
+                        {0.0f, 0.0f, 0.0f, 1.0f},
+                        {1.0f, 1.0f, 1.0f, 1.0f},
+                        {1.0f, 1.0f, 1.0f, 1.0f},
+                        {0.0f, 2.0f, 0.0f, 3.0f},
+                    });
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("clear")) {
+                    lights.clear();
+                }
+                ImGui::Separator();
+                size_t removed = lights.size();
+                for (size_t i = 0; i < lights.size(); ++i) {
+                    ImGui::PushID(int(i));
+                    if (ImGui::TreeNode("light", "Light%lu", (unsigned long)i)) {
+                        ImGui::ColorEdit4("ambient", lights[i].ambient);
+                        ImGui::ColorEdit4("diffuse", lights[i].diffuse);
+                        ImGui::ColorEdit4("specular", lights[i].specular);
+                        ImGui::Text("position:");
+                        ImGui::SliderFloat("x", &lights[i].position[0], -5.0f, 5.0f);
+                        ImGui::SliderFloat("y", &lights[i].position[1], -5.0f, 5.0f);
+                        ImGui::SliderFloat("z", &lights[i].position[2], -5.0f, 5.0f);
+                        ImGui::SliderFloat("range", &lights[i].position[3], 0.0f, 10.0f, "%.2f (0: unlimited)");
+                        if (ImGui::Button("remove")) {
+                            removed = i;
+                        }
+                        ImGui::TreePop();
+                    }
+                    ImGui::PopID();
                 }
+                if (removed < lights.size()) {
+                    lights.erase(lights.begin() + removed);
+                }
+                ImGui::EndTabItem();
             }
             ImGui::EndTabBar();
         }
@@ -767,6 +1502,14 @@ private:
                          ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
                          ImGuiWindowFlags_NoNav);
         {
+            if (!model_uploaded) {
+                double total  = load_progress.total_bytes / 1e6;
+                double parsed = load_progress.parsed_bytes / 1e6;
+                ImGui::Text("loading %s: %.1f / %.1f MB, vertices: %lu", model_filename, parsed, total,
+                            (unsigned long)load_progress.vertices);
+                ImGui::ProgressBar(total > 0 ? parsed / total : 0.0f);
+                ImGui::Separator();
+            }
             if (ImGui::IsMousePosValid())
                 ImGui::Text("Mouse Position: (%6.1f,%6.1f)", io.MousePos.x, io.MousePos.y);
             else
@@ -779,8 +1522,27 @@ private:
             ImGui::Text("view distance: %.2f", view_distance);
             ImGui::Text("horizonal angle:%.1f", horizonal_angle);
             ImGui::Text("pitch angle:%.1f", pitch_angle);
+            if (lod_ranges.size() > 1) {
+                ImGui::Text("LOD %lu: %lu faces, projected %.0f px", (unsigned long)lod_level,
+                            (unsigned long)lod_ranges[lod_level].second / 3, projected_pixels);
+            }
+            if (tiles_used) {
+                ImGui::Text("lights: %lu, %.1f per %dx%d tile", (unsigned long)lights.size(),
+                            double(light_tiles.entries) / (light_tiles.tiles_x * light_tiles.tiles_y),
+                            LIGHT_TILE_SIZE, LIGHT_TILE_SIZE);
+            } else {
+                ImGui::Text("lights: %lu", (unsigned long)lights.size());
+            }
+            if (meshlet_culling && model_uploaded && lod_level == 0 && !model_meshlets.empty()) {
+                ImGui::Text("meshlets: %lu / %lu visible, culled %lu frustum, %lu backface, %lu faces",
+                            (unsigned long)cull_stats.visible, (unsigned long)model_meshlets.size(),
+                            (unsigned long)cull_stats.frustum_culled, (unsigned long)cull_stats.backface_culled,
+                            (unsigned long)cull_stats.culled_triangles);
+            }
             ImGui::Separator();
             ImGui::Text("FPS: %.2f", ImGui::GetIO().Framerate);
+            ImGui::Text("GL calls: %lu / frame, %lu skipped by state cache", (unsigned long)frame_gl_calls,
+                        (unsigned long)frame_skipped);
         }
         ImGui::End();
 
@@ -818,6 +1580,9 @@ private:
 void mainLoop() {
     ImGuiIO &io = ImGui::GetIO();
     while (!glfwWindowShouldClose(window)) {
+        size_t gl_calls_before = gl_call_count();
+        size_t skipped_before  = gl_state.skipped();
+
         // Poll and handle events (inputs, window resize, etc.)
         // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your
         // inputs.
@@ -827,6 +1592,13 @@ void mainLoop() {
         // two flags.
         glfwPollEvents();
 
+        // 后台加载完成后上传模型，加载过程中逐段上传已解析的部分
+        if (!model_uploaded && model_ready) {
+            uploadModel();
+        } else if (!model_uploaded && !stream.overflow) {
+            consumeStream();
+        }
+
         // ImGUI preparation for the frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -841,15 +1613,22 @@ void mainLoop() {
             float y = viewport.y * io.DisplayFramebufferScale.y;
             float w = viewport.w * io.DisplayFramebufferScale.x;
             float h = viewport.h * io.DisplayFramebufferScale.y;
-            glViewport(x, y, w, h);
+            counted_gl(glViewport, x, y, w, h);
+            counted_gl(glGetIntegerv, GL_VIEWPORT, framebuffer_viewport);
         }
 
-        // 设置模型姿态
+        // 设置模型姿态、观察与投影矩阵
+        // 各着色器从 Camera 块读取观察与投影矩阵，不使用固定管线的矩阵栈
         set_model_transform();
+        set_lookat();
+        mat_proj = glm::perspective(glm::radians(fovy), 1.0f, 0.1f, 1000.0f);
 
         // 拾取模式
         pick_sucess = false;
-        if (lb_clicked && select_mode != SELECT_NONE) {
+        if (pick_buffer.pending()) {
+            resolve_select();
+        }
+        if (lb_clicked && select_mode != SELECT_NONE && model_uploaded) {
             do_select();
         }
 
@@ -863,40 +1642,28 @@ void mainLoop() {
         // int display_w, display_h;
         // glfwGetFramebufferSize(window, &display_w, &display_h);
         // glViewport(0, 0, display_w, display_h);
-        glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        counted_gl(glClearColor, clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+        counted_gl(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 三维物体渲染
         // 共用摄像机位姿、投影矩阵、深度缓存
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_CULL_FACE);
-
-        glMatrixMode(GL_PROJECTION);
-        glPushMatrix();
-
-        mat_proj = glm::perspective(glm::radians(fovy), 1.0f, 0.1f, 1000.0f);
-        glLoadMatrixf(glm::value_ptr(mat_proj));
-
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadIdentity();
-        set_lookat();
-
-        // 光源及材质设置
-        set_phong_uniform();
+        counted_gl(glEnable, GL_DEPTH_TEST);
+        counted_gl(glEnable, GL_CULL_FACE);
 
-        // 简单着色器参数设置
-        set_simple_uniform();
+        // 按模型的投影大小选择 LOD 级别
+        update_lod();
 
-        // 保存视图矩阵
-        glPushMatrix();
+        // 观察与投影矩阵、光源及材质设置
+        update_uniforms();
 
         if (draw_coord) {
             draw_coordinate();
         }
 
         // 绘制模型或线框
-        if (enable_wire_view) {
+        if (drawn_index_count == 0) {
+            // 模型尚未加载
+        } else if (enable_wire_view) {
             draw_wire_model();
         } else {
             draw_model();
@@ -918,52 +1685,90 @@ void mainLoop() {
         }
 
         // 还原状态
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
-        glMatrixMode(GL_MODELVIEW);
-        glPopMatrix();
-        glPopMatrix();
-        glMatrixMode(GL_PROJECTION);
-        glPopMatrix();
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-        // 渲染 imgui
-        glUseProgram(0);
+        counted_gl(glDisable, GL_DEPTH_TEST);
+        counted_gl(glDisable, GL_CULL_FACE);
+
+        // 渲染 imgui，ImGui 会保存并恢复程序、VAO、缓冲区绑定与多边形模式，状态缓存仍然有效
+        frame_gl_calls = gl_call_count() - gl_calls_before;
+        frame_skipped  = gl_state.skipped() - skipped_before;
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+
+        // 统计首帧时间以及模型首次显示的时间
+        if (frame_count++ == 0) {
+            printf("first frame after %.1f ms\n", elapsed_ms());
+        }
+        if (model_uploaded && !model_frame_reported) {
+            model_frame_reported = true;
+            printf("first frame with model after %.1f ms\n", elapsed_ms());
+        }
+
+        // 基准测试：从模型上传后的第一帧结束开始计时
+        if (bench_frames && model_uploaded) {
+            bench_frame();
+        }
     }
 }
 
-void draw_model_select_vertex() {
-    model_transform();
+// 统计基准测试的帧时间；光源基准测试每项结束后切换到下一项，全部完成后关闭窗口
+void bench_frame() {
+    auto now = std::chrono::steady_clock::now();
+    if (bench_count++ == 0) {
+        bench_start    = now;
+        bench_gl_calls = 0;
+        bench_skipped  = 0;
+        return;
+    }
+    bench_gl_calls += frame_gl_calls;
+    bench_skipped += frame_skipped;
+    if (bench_count <= bench_frames) {
+        return;
+    }
+    double ms    = std::chrono::duration<double, std::milli>(now - bench_start).count();
+    double calls   = double(bench_gl_calls) / bench_frames;
+    double skipped = double(bench_skipped) / bench_frames;
+    if (!bench_lights) {
+        printf("bench: %lu frames, %.3f ms/frame, %.1f GL calls/frame, %.1f skipped (%s layout, %s, %s profile)\n",
+               (unsigned long)bench_frames, ms / bench_frames, calls, skipped,
+               vbo_interleaved ? "interleaved" : "separate", optimize_model ? "optimized" : "file order",
+               core_profile ? "core" : "compatibility");
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+        return;
+    }
+    printf("bench: %4lu lights, %-11s %.3f ms/frame, %.1f GL calls/frame (%s profile)\n",
+           (unsigned long)lights.size(), tiled_lighting ? "tiled," : "all lights,", ms / bench_frames, calls,
+           core_profile ? "core" : "compatibility");
+    bench_count = 0;
+    if (++bench_step < bench_plan.size()) {
+        apply_bench_step();
+    } else {
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+}
 
-    glInitNames();
-    glPushName(-1);
-    auto vd = model.vertices.data();
-    for (size_t v = 0; v < model.vertices.size(); v += 3) {
-        glLoadName(v);
-        glBegin(GL_POINTS);
-        glVertex3fv(vd + v);
-        glEnd();
+// 按 bench_plan 的当前项设置光源数与是否分块剔除
+void apply_bench_step() {
+    if (bench_step >= bench_plan.size()) {
+        return;
     }
+    auto [count, tiled] = bench_plan[bench_step];
+    generate_bench_lights(count);
+    tiled_lighting = tiled;
 }
 
-void draw_model_select_face() {
-    model_transform();
-
-    glInitNames();
-    glPushName(-1);
-    auto vd = model.vertices.data();
-    auto fd = model.indices.data();
-    for (size_t f = 0; f < model.indices.size(); f += 3) {
-        glLoadName(f);
-        glBegin(GL_TRIANGLES);
-        glVertex3fv(vd + fd[f] * 3);
-        glVertex3fv(vd + fd[f + 1] * 3);
-        glVertex3fv(vd + fd[f + 2] * 3);
-        glEnd();
+// 在模型周围随机放置 count 个作用半径为 0.8 的彩色光源，随机数种子固定，各次测试结果可比
+void generate_bench_lights(size_t count) {
+    std::mt19937 rng(count);
+    std::uniform_real_distribution<GLfloat> position(-1.5f, 1.5f), color(0.2f, 1.0f);
+    lights.resize(count);
+    for (auto &light : lights) {
+        light = {
+            {0.02f, 0.02f, 0.02f, 1.0f},
+            {color(rng), color(rng), color(rng), 1.0f},
+            {0.5f, 0.5f, 0.5f, 1.0f},
+            {position(rng), position(rng), position(rng), 0.8f},
+        };
     }
 }
 };
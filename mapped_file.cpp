@@ -0,0 +1,131 @@
+#include "mapped_file.h"
+
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace glss {
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        addr   = std::exchange(other.addr, nullptr);
+        length = std::exchange(other.length, 0);
+        opened = std::exchange(other.opened, false);
+#ifdef _WIN32
+        file_handle    = std::exchange(other.file_handle, nullptr);
+        mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::string_view filename) {
+    close();
+    HANDLE file = CreateFileA(std::string(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    opened      = true;
+    // 空文件无法建立映射，视为打开成功的零长度文件
+    if (file_size.QuadPart == 0) {
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+    mapping_handle = mapping;
+    addr           = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (addr == nullptr) {
+        close();
+        return false;
+    }
+    length = static_cast<std::size_t>(file_size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (addr != nullptr) {
+        UnmapViewOfFile(addr);
+    }
+    if (mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle != nullptr) {
+        CloseHandle(file_handle);
+    }
+    addr           = nullptr;
+    length         = 0;
+    opened         = false;
+    file_handle    = nullptr;
+    mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(std::string_view filename) {
+    close();
+    int fd = ::open(std::string(filename).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    // 空文件无法建立映射，视为打开成功的零长度文件
+    if (st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        // 解析器从头到尾顺序扫描
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        addr   = static_cast<const char *>(p);
+        length = st.st_size;
+    }
+    // 映射建立后即可关闭文件描述符
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (addr != nullptr) {
+        munmap(const_cast<char *>(addr), length);
+    }
+    addr   = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
+
+}; // namespace glss
@@ -0,0 +1,54 @@
+#ifndef MAPPED_FILE_H__
+#define MAPPED_FILE_H__
+
+#include <cstddef>
+#include <string_view>
+
+inline namespace glss {
+
+// 只读方式映射到内存的文件，用法与 ifstream 类似：
+// 构造或 open() 后用 is_open() 检查是否成功
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(std::string_view filename) {
+        open(filename);
+    }
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool open(std::string_view filename);
+    void close();
+
+    bool is_open() const {
+        return opened;
+    }
+    const char *data() const {
+        return addr;
+    }
+    std::size_t size() const {
+        return length;
+    }
+    std::string_view view() const {
+        return {addr, length};
+    }
+
+private:
+    const char *addr   = nullptr;
+    std::size_t length = 0;
+    bool opened        = false;
+#ifdef _WIN32
+    void *file_handle    = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+};
+
+} // namespace glss
+
+#endif
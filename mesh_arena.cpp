@@ -0,0 +1,111 @@
+#include "mesh_arena.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace glss {
+
+// 预留内存的对齐，足以容纳任意数组元素
+constexpr std::size_t ARENA_ALIGNMENT = alignof(std::max_align_t);
+
+MeshArena::~MeshArena() {
+    arena.reset();
+    if (buffer) {
+        upstream->deallocate(buffer, buffer_size, ARENA_ALIGNMENT);
+    }
+}
+
+bool MeshArena::reserve(std::size_t vertices, std::size_t normals, std::size_t indices) {
+    if (arena || live_allocations != 0) {
+        return false;
+    }
+    // 三个数组的元素都是 4 字节，依次紧挨着分配不需要额外的对齐填充
+    buffer_size = (vertices + normals + indices) * 4;
+    if (buffer_size == 0) {
+        arena.emplace(upstream);
+        return true;
+    }
+    buffer = upstream->allocate(buffer_size, ARENA_ALIGNMENT);
+    ++allocation_count;
+    arena.emplace(buffer, buffer_size, upstream);
+    return true;
+}
+
+void *MeshArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (!arena) {
+        ++allocation_count;
+        ++live_allocations;
+        return upstream->allocate(bytes, alignment);
+    }
+    // 预留的内存足够时 monotonic_buffer_resource 不会向上游申请，超出预留大小的每次分配都计入分配次数
+    arena_bytes += bytes;
+    if (arena_bytes > buffer_size) {
+        ++allocation_count;
+    }
+    return arena->allocate(bytes, alignment);
+}
+
+void MeshArena::do_deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+    if (!arena) {
+        --live_allocations;
+        upstream->deallocate(p, bytes, alignment);
+    }
+    // 预留之后的内存在 arena 销毁时统一释放
+}
+
+std::size_t peak_rss_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    // VmHWM 可以通过 clear_refs 重置，比 getrusage 的 ru_maxrss 更适合分段测量
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return std::size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+bool reset_peak_rss() {
+#ifdef __linux__
+    std::FILE *f = std::fopen("/proc/self/clear_refs", "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = std::fputs("5", f) >= 0;
+    return std::fclose(f) == 0 && ok;
+#else
+    return false;
+#endif
+}
+
+}; // namespace glss
@@ -0,0 +1,96 @@
+#ifndef MESH_ARENA_H__
+#define MESH_ARENA_H__
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+inline namespace glss {
+
+// 统计分配次数与字节数后转交上游的内存资源，可在多个线程中同时使用
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {
+    }
+
+    std::size_t allocations() const {
+        return allocation_count;
+    }
+    std::size_t allocated_bytes() const {
+        return allocated_total;
+    }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocation_count;
+        allocated_total += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource *upstream;
+    std::atomic<std::size_t> allocation_count = 0;
+    std::atomic<std::size_t> allocated_total  = 0;
+};
+
+// 网格数组使用的内存：预留前直接转交上游；
+// 预留后由 monotonic_buffer_resource 在一块精确大小的内存中依次分配，释放不归还，超出部分向上游申请
+// 只应在一个线程中使用
+class MeshArena : public std::pmr::memory_resource {
+public:
+    explicit MeshArena(std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : upstream(upstream) {
+    }
+    ~MeshArena();
+
+    MeshArena(const MeshArena &)            = delete;
+    MeshArena &operator=(const MeshArena &) = delete;
+
+    // 为 vertices、normals、indices 三个数组按元素个数一次预留内存
+    // 只能在尚无未释放的分配时调用一次，否则返回 false
+    bool reserve(std::size_t vertices, std::size_t normals, std::size_t indices);
+
+    // 向上游申请内存的次数，预留的整块内存计为一次
+    std::size_t allocations() const {
+        return allocation_count;
+    }
+    std::size_t reserved_bytes() const {
+        return buffer_size;
+    }
+    // 预留之后的分配超出预留大小的字节数
+    std::size_t overflow_bytes() const {
+        return arena_bytes > buffer_size ? arena_bytes - buffer_size : 0;
+    }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource *upstream;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+    void *buffer                 = nullptr;
+    std::size_t buffer_size      = 0;
+    std::size_t arena_bytes      = 0; // 预留之后经 arena 分配的字节数
+    std::size_t allocation_count = 0;
+    std::size_t live_allocations = 0; // 预留之前尚未释放的分配数
+};
+
+// 进程的峰值常驻内存（字节），无法获取时返回 0
+std::size_t peak_rss_bytes();
+
+// 把峰值常驻内存重置为当前值，以便测量之后一段时间内的峰值；仅 Linux 支持，其他平台返回 false
+bool reset_peak_rss();
+
+} // namespace glss
+
+#endif
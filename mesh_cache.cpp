@@ -0,0 +1,151 @@
+#include <GL/glew.h>
+
+#include "mapped_file.h"
+#include "mesh_loader.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+using namespace std;
+
+namespace glss {
+
+// 缓存文件格式：文件头之后依次是顶点、法向量、索引数组，
+// 各数组按 CACHE_ALIGNMENT 对齐，映射到内存后可直接交给 glBufferData
+constexpr char CACHE_MAGIC[8]      = {'G', 'L', 'S', 'S', 'M', 'E', 'S', 'H'};
+// 格式或加载结果改变时递增版本，使旧的缓存失效：2 按 (顶点, 法向量) 索引合并 OBJ 的角，
+// 3 按面积和角度加权生成法向量，4 按顶点缓存重排三角形，5 按首次使用的顺序重新编号顶点，6 补算没有法向量的角，
+// 7 合并 STL 顶点时检查全部相邻格子
+constexpr uint32_t CACHE_VERSION   = 7;
+constexpr uint64_t CACHE_ALIGNMENT = 64;
+constexpr const char *CACHE_SUFFIX = ".meshcache";
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    // 源文件的大小和修改时间，任一不符即视为缓存失效
+    uint64_t source_size;
+    int64_t source_mtime;
+    // 各数组的元素个数及其在文件中的字节偏移
+    uint64_t vertex_count, normal_count, index_count;
+    uint64_t vertex_offset, normal_offset, index_offset;
+};
+
+static string cache_filename(string_view source_filename) {
+    return string(source_filename) + CACHE_SUFFIX;
+}
+
+static uint64_t align_up(uint64_t n) {
+    return (n + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+}
+
+// 读取源文件的大小与修改时间
+static bool source_stamp(string_view source_filename, uint64_t &size, int64_t &mtime) {
+    error_code ec;
+    filesystem::path path(source_filename);
+    size = filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto time = filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    mtime = time.time_since_epoch().count();
+    return true;
+}
+
+bool load_mesh_cache(std::string_view source_filename, Mesh<> &mesh) {
+    uint64_t size;
+    int64_t mtime;
+    if (!source_stamp(source_filename, size, mtime)) {
+        return false;
+    }
+
+    MappedFile file(cache_filename(source_filename));
+    if (!file.is_open() || file.size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+        header.header_size != sizeof(MeshCacheHeader) || header.source_size != size || header.source_mtime != mtime) {
+        return false;
+    }
+
+    // 检查各数组均落在文件范围内
+    auto in_file = [&](uint64_t offset, uint64_t count, size_t element_size) {
+        return offset <= file.size() && count <= (file.size() - offset) / element_size;
+    };
+    if (!in_file(header.vertex_offset, header.vertex_count, sizeof(GLfloat)) ||
+        !in_file(header.normal_offset, header.normal_count, sizeof(GLfloat)) ||
+        !in_file(header.index_offset, header.index_count, sizeof(GLuint))) {
+        return false;
+    }
+
+    auto vertices = reinterpret_cast<const GLfloat *>(file.data() + header.vertex_offset);
+    auto normals  = reinterpret_cast<const GLfloat *>(file.data() + header.normal_offset);
+    auto indices  = reinterpret_cast<const GLuint *>(file.data() + header.index_offset);
+    mesh.vertices.assign(vertices, vertices + header.vertex_count);
+    mesh.normals.assign(normals, normals + header.normal_count);
+    mesh.indices.assign(indices, indices + header.index_count);
+    return true;
+}
+
+bool save_mesh_cache(std::string_view source_filename, const Mesh<> &mesh) {
+    MeshCacheHeader header = {};
+    if (!source_stamp(source_filename, header.source_size, header.source_mtime)) {
+        return false;
+    }
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version       = CACHE_VERSION;
+    header.header_size   = sizeof(MeshCacheHeader);
+    header.vertex_count  = mesh.vertices.size();
+    header.normal_count  = mesh.normals.size();
+    header.index_count   = mesh.indices.size();
+    header.vertex_offset = align_up(sizeof(MeshCacheHeader));
+    header.normal_offset = align_up(header.vertex_offset + header.vertex_count * sizeof(GLfloat));
+    header.index_offset  = align_up(header.normal_offset + header.normal_count * sizeof(GLfloat));
+
+    // 先写入临时文件再改名，避免中途失败留下不完整的缓存
+    string filename = cache_filename(source_filename);
+    string tmp_name = filename + ".tmp";
+    {
+        ofstream fout(filesystem::path(tmp_name), ios::binary | ios::trunc);
+        if (!fout.is_open()) {
+            return false;
+        }
+        auto write_at = [&](uint64_t offset, const void *data, size_t bytes) {
+            static const char zeros[CACHE_ALIGNMENT] = {};
+            fout.write(zeros, offset - static_cast<uint64_t>(fout.tellp()));
+            fout.write(static_cast<const char *>(data), bytes);
+        };
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        write_at(header.vertex_offset, mesh.vertices.data(), mesh.vertices.size() * sizeof(GLfloat));
+        write_at(header.normal_offset, mesh.normals.data(), mesh.normals.size() * sizeof(GLfloat));
+        write_at(header.index_offset, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+        if (!fout) {
+            fout.close();
+            error_code ec;
+            filesystem::remove(tmp_name, ec);
+            return false;
+        }
+    }
+
+    error_code ec;
+    filesystem::rename(tmp_name, filename, ec);
+    if (ec) {
+        filesystem::remove(tmp_name, ec);
+        return false;
+    }
+    return true;
+}
+
+}; // namespace glss
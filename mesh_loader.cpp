@@ -0,0 +1,32 @@
+#include <GL/glew.h>
+
+#include "mesh_loader.h"
+#include "mesh_ops.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <string>
+
+using namespace std;
+
+namespace glss {
+
+Mesh<> load_mesh(std::string_view filename, LoadProgress *progress, MeshStream *stream, float weld_epsilon,
+                 MeshArena *arena) {
+    string ext = filesystem::path(filename).extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return tolower(c); });
+
+    if (ext == ".stl") {
+        return load_stl(filename, weld_epsilon, 0, progress);
+    }
+    Mesh<> mesh = ext == ".ply" ? load_ply(filename, progress, arena)
+                                : load_bunny_data(filename, 0, progress, stream, arena);
+    if (mesh.normals.size() != mesh.vertices.size()) {
+        generate_normals(mesh, &ThreadPool::global());
+    }
+    return mesh;
+}
+
+}; // namespace glss
@@ -0,0 +1,118 @@
+#ifndef MESH_LOADER_H__
+#define MESH_LOADER_H__
+
+#include "mesh_arena.h"
+#include "utils.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+inline namespace glss {
+
+// 加载进度，由加载线程更新，可在其他线程中读取
+struct LoadProgress {
+    std::atomic<std::size_t> total_bytes  = 0; // 文件大小
+    std::atomic<std::size_t> parsed_bytes = 0; // 已解析的字节数
+    std::atomic<std::size_t> vertices     = 0; // 已读入的顶点数
+};
+
+// 加载过程中按文件顺序发布的一段网格数据，偏移均以元素个数计
+struct MeshPiece {
+    std::size_t vertex_offset, normal_offset, index_offset;
+    std::size_t max_index; // 本段索引引用的最大顶点编号，本段没有面片时为 0
+    Mesh<> data;
+};
+
+// 加载线程与渲染线程之间传递网格分段的通道：
+// 加载线程先给出最终大小，再按顺序发布各段；渲染线程预先分配缓冲区后逐段追加
+class MeshStream {
+public:
+    // 以下由加载线程调用
+    void reserve(std::size_t vertices, std::size_t normals, std::size_t indices) {
+        std::lock_guard lock(mutex);
+        vertex_capacity = vertices;
+        normal_capacity = normals;
+        index_capacity  = indices;
+        has_layout      = true;
+    }
+    void publish(MeshPiece &&piece) {
+        std::lock_guard lock(mutex);
+        if (!is_aborted) {
+            pieces.push_back(std::move(piece));
+        }
+    }
+    // 已发布的数据与最终模型不一致（例如之后需要合并顶点），渲染线程应改为等待完整模型
+    void abort() {
+        std::lock_guard lock(mutex);
+        is_aborted = true;
+        pieces.clear();
+    }
+
+    // 以下由渲染线程调用
+    bool layout(std::size_t &vertices, std::size_t &normals, std::size_t &indices) {
+        std::lock_guard lock(mutex);
+        vertices = vertex_capacity;
+        normals  = normal_capacity;
+        indices  = index_capacity;
+        return has_layout;
+    }
+    std::vector<MeshPiece> take() {
+        std::lock_guard lock(mutex);
+        std::vector<MeshPiece> taken;
+        taken.swap(pieces);
+        return taken;
+    }
+    bool aborted() {
+        std::lock_guard lock(mutex);
+        return is_aborted;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<MeshPiece> pieces;
+    std::size_t vertex_capacity = 0;
+    std::size_t normal_capacity = 0;
+    std::size_t index_capacity  = 0;
+    bool has_layout             = false;
+    bool is_aborted             = false;
+};
+
+// 读取 OBJ 文件，文件以只读方式映射到内存后解析
+// threads 为解析线程数：0 表示使用全局线程池，1 表示串行解析
+// progress 不为空时解析过程中会持续更新其中的计数
+// stream 不为空时先预扫描文件得到最终大小，再把解析完的各段按顺序发布出去
+// arena 不为空时先预扫描 v、vn、f 的记录数，三个数组在 arena 中按精确大小一次分配
+// （没有 vn 时按顶点数为之后生成的法向量预留）；返回的网格沿用 arena，只能移动构造或移动赋值给同样使用 arena 的网格
+Mesh<> load_bunny_data(std::string_view obj_filename, unsigned threads = 0, LoadProgress *progress = nullptr,
+                       MeshStream *stream = nullptr, MeshArena *arena = nullptr);
+
+// 读取 PLY 文件，支持 ascii、binary_little_endian 和 binary_big_endian 格式
+// 读入 vertex 元素的 x y z（以及 nx ny nz）属性和 face 元素的 vertex_indices 列表，其余元素与属性均跳过
+// arena 不为空时按文件头中的元素个数在其中预留内存，面片均为三角形时大小精确
+Mesh<> load_ply(std::string_view ply_filename, LoadProgress *progress = nullptr, MeshArena *arena = nullptr);
+
+// 合并 STL 顶点时的默认距离，相对于模型包围盒对角线的长度
+constexpr float DEFAULT_WELD_EPSILON = 1e-6f;
+
+// 读取二进制 STL 文件，用空间网格散列合并距离不超过 weld_epsilon（相对包围盒对角线）的顶点，
+// 再生成顶点法向量；threads 为 1 时串行执行，否则使用全局线程池
+Mesh<> load_stl(std::string_view stl_filename, float weld_epsilon = DEFAULT_WELD_EPSILON, unsigned threads = 0,
+                LoadProgress *progress = nullptr);
+
+// 按扩展名选择加载函数：.ply 使用 load_ply，.stl 使用 load_stl，其余按 OBJ 读取；只有 OBJ 支持分段发布
+// 文件没有为每个顶点提供法向量时，用全局线程池按面积和角度加权生成
+// arena 传给 OBJ 和 PLY 加载函数；STL 合并顶点前的大小无法预知，不使用 arena
+Mesh<> load_mesh(std::string_view filename, LoadProgress *progress = nullptr, MeshStream *stream = nullptr,
+                 float weld_epsilon = DEFAULT_WELD_EPSILON, MeshArena *arena = nullptr);
+
+// 二进制网格缓存，保存在模型文件旁的 <模型文件名>.meshcache 中
+// 缓存记录源文件的大小和修改时间，二者与源文件一致时才会被读取
+bool load_mesh_cache(std::string_view source_filename, Mesh<> &mesh);
+bool save_mesh_cache(std::string_view source_filename, const Mesh<> &mesh);
+
+} // namespace glss
+
+#endif
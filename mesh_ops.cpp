@@ -0,0 +1,1279 @@
+#include <GL/glew.h>
+
+#include "mesh_ops.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace glss {
+
+// 以 64 位整数为键的开放寻址哈希表，线性探测，只支持插入
+class OpenHashMap {
+public:
+    explicit OpenHashMap(size_t expected = 0) {
+        size_t capacity = 16;
+        while (capacity < expected * 2) {
+            capacity *= 2;
+        }
+        resize(capacity);
+    }
+
+    // key 不存在时以 value 插入；返回表中 key 对应的值
+    GLuint insert(uint64_t key, GLuint value) {
+        for (size_t i = bucket(key);; i = (i + 1) & mask) {
+            if (slots[i].key == key) {
+                return slots[i].value;
+            }
+            if (slots[i].key == EMPTY) {
+                slots[i] = {key, value};
+                if (++count * 2 > slots.size()) {
+                    resize(slots.size() * 2);
+                }
+                return value;
+            }
+        }
+    }
+
+    // 返回 key 对应的值，不存在时返回 NONE
+    GLuint find(uint64_t key) const {
+        for (size_t i = bucket(key);; i = (i + 1) & mask) {
+            if (slots[i].key == key) {
+                return slots[i].value;
+            }
+            if (slots[i].key == EMPTY) {
+                return NONE;
+            }
+        }
+    }
+
+    constexpr static GLuint NONE = ~GLuint(0);
+
+private:
+    constexpr static uint64_t EMPTY = ~uint64_t(0);
+
+    struct Slot {
+        uint64_t key;
+        GLuint value;
+    };
+
+    vector<Slot> slots;
+    size_t mask  = 0;
+    int shift    = 0;
+    size_t count = 0;
+
+    // Fibonacci 散列，取乘积的高位
+    size_t bucket(uint64_t key) const {
+        return (key * 0x9E3779B97F4A7C15ull) >> shift;
+    }
+
+    void resize(size_t capacity) {
+        vector<Slot> old(capacity, Slot{EMPTY, 0});
+        old.swap(slots);
+        mask  = capacity - 1;
+        shift = 64;
+        for (size_t c = capacity; c > 1; c /= 2) {
+            --shift;
+        }
+        for (const auto &slot : old) {
+            if (slot.key != EMPTY) {
+                size_t i = bucket(slot.key);
+                while (slots[i].key != EMPTY) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = slot;
+            }
+        }
+    }
+};
+
+void weld_vertex_normals(Mesh<> &mesh, const std::vector<GLuint> &normal_indices) {
+    GLuint vertex_count = mesh.vertices.size() / 3;
+    GLuint normal_count = mesh.normals.size() / 3;
+
+    // 合并后的顶点数通常与原顶点数、法向量数中的较大者相近
+    size_t expected = max(vertex_count, normal_count);
+    OpenHashMap map(expected);
+    std::pmr::vector<GLfloat> vertices, normals;
+    vertices.reserve(expected * 3);
+    normals.reserve(expected * 3);
+
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        GLuint v  = mesh.indices[i];
+        GLuint vn = min(normal_indices[i], normal_count); // normal_count 统一表示没有法向量
+
+        GLuint next = vertices.size() / 3;
+        GLuint id   = map.insert(uint64_t(v) << 32 | vn, next);
+        if (id == next) {
+            auto position = mesh.vertices.begin() + size_t(v) * 3;
+            vertices.insert(vertices.end(), position, position + 3);
+            if (vn < normal_count) {
+                auto normal = mesh.normals.begin() + size_t(vn) * 3;
+                normals.insert(normals.end(), normal, normal + 3);
+            } else {
+                normals.insert(normals.end(), {0.0f, 0.0f, 0.0f});
+            }
+        }
+        mesh.indices[i] = id;
+    }
+
+    mesh.vertices = std::move(vertices);
+    mesh.normals  = std::move(normals);
+}
+
+// 顶点合并时每块至少处理的顶点或索引个数
+constexpr size_t MIN_WELD_BLOCK = 1 << 16;
+
+// 网格坐标每个轴占 21 位，三个轴拼成 64 位的键，最高位恒为 0，不会与 EMPTY 冲突
+constexpr int CELL_BITS         = 21;
+constexpr int64_t CELL_LIMIT    = (int64_t(1) << CELL_BITS) - 1;
+constexpr uint64_t CELL_MASK    = (uint64_t(1) << CELL_BITS) - 1;
+
+static uint64_t cell_key(int64_t x, int64_t y, int64_t z) {
+    return uint64_t(x) | uint64_t(y) << CELL_BITS | uint64_t(z) << (2 * CELL_BITS);
+}
+
+void weld_positions(Mesh<> &mesh, float epsilon, ThreadPool *pool) {
+    size_t vertex_count = mesh.vertices.size() / 3;
+    if (vertex_count == 0) {
+        return;
+    }
+    const GLfloat *position = mesh.vertices.data();
+    size_t blocks           = block_count(pool, vertex_count, MIN_WELD_BLOCK);
+
+    // 包围盒
+    struct Bounds {
+        float lo[3] = {INFINITY, INFINITY, INFINITY};
+        float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    };
+    vector<Bounds> block_bounds(blocks);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t b, size_t first, size_t last) {
+        auto &bounds = block_bounds[b];
+        for (size_t v = first; v < last; ++v) {
+            for (int a = 0; a < 3; ++a) {
+                bounds.lo[a] = min(bounds.lo[a], position[v * 3 + a]);
+                bounds.hi[a] = max(bounds.hi[a], position[v * 3 + a]);
+            }
+        }
+    });
+    Bounds bounds;
+    for (const auto &part : block_bounds) {
+        for (int a = 0; a < 3; ++a) {
+            bounds.lo[a] = min(bounds.lo[a], part.lo[a]);
+            bounds.hi[a] = max(bounds.hi[a], part.hi[a]);
+        }
+    }
+
+    // 格子边长：每个轴上的格子数不超过 CELL_LIMIT - 1，为相邻格子的坐标留出余量
+    float extent = 0, diagonal = 0;
+    for (int a = 0; a < 3; ++a) {
+        float d = bounds.hi[a] - bounds.lo[a];
+        extent  = max(extent, d);
+        diagonal += d * d;
+    }
+    double cell = max(double(epsilon) * sqrt(diagonal), double(extent) / (CELL_LIMIT - 1));
+    if (!(cell > 0)) {
+        cell = 1;
+    }
+    float cell2 = cell * cell;
+
+    // 格子坐标用双精度计算，避免坐标较大时丢失小数部分
+    auto grid = [&](size_t v, int a) {
+        return (double(position[v * 3 + a]) - bounds.lo[a]) / cell;
+    };
+    auto grid_cell = [&](double g) {
+        return min<int64_t>(int64_t(g), CELL_LIMIT - 2);
+    };
+    auto distance2 = [&](size_t u, size_t v) {
+        float d2 = 0;
+        for (int a = 0; a < 3; ++a) {
+            float d = position[u * 3 + a] - position[v * 3 + a];
+            d2 += d * d;
+        }
+        return d2;
+    };
+
+    vector<uint64_t> keys(vertex_count);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t, size_t first, size_t last) {
+        for (size_t v = first; v < last; ++v) {
+            keys[v] = cell_key(grid_cell(grid(v, 0)), grid_cell(grid(v, 1)), grid_cell(grid(v, 2)));
+        }
+    });
+
+    // 按键的散列值把顶点分到若干分片，各分片独立建表，互不加锁
+    // 每块内按分片计数、求前缀和后散列到 order 中，同一分片内的顶点保持编号递增
+    int shard_bits = 0;
+    while ((size_t(1) << shard_bits) < blocks) {
+        ++shard_bits;
+    }
+    size_t shards   = size_t(1) << shard_bits;
+    auto shard_of   = [&](uint64_t key) { return size_t((key * 0x9E3779B97F4A7C15ull) >> 32) & (shards - 1); };
+    vector<size_t> histogram(blocks * shards);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t b, size_t first, size_t last) {
+        for (size_t v = first; v < last; ++v) {
+            ++histogram[b * shards + shard_of(keys[v])];
+        }
+    });
+    vector<size_t> shard_begin(shards + 1);
+    for (size_t s = 0, offset = 0; s < shards; ++s) {
+        shard_begin[s] = offset;
+        for (size_t b = 0; b < blocks; ++b) {
+            size_t n                  = histogram[b * shards + s];
+            histogram[b * shards + s] = offset;
+            offset += n;
+        }
+    }
+    shard_begin[shards] = vertex_count;
+    vector<GLuint> order(vertex_count);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t b, size_t first, size_t last) {
+        size_t *offset = &histogram[b * shards];
+        for (size_t v = first; v < last; ++v) {
+            order[offset[shard_of(keys[v])]++] = v;
+        }
+    });
+
+    // 每个格子记录落入其中的编号最小的顶点
+    vector<OpenHashMap> maps(shards);
+    vector<GLuint> first_in_cell(vertex_count);
+    parallel_blocks(pool, shards, shards, [&](size_t s, size_t, size_t) {
+        // 三角形汤中每个位置通常被多个角共用，表按顶点数的四分之一起步，不够时自动扩容
+        maps[s] = OpenHashMap((shard_begin[s + 1] - shard_begin[s]) / 4);
+        for (size_t i = shard_begin[s]; i < shard_begin[s + 1]; ++i) {
+            GLuint v         = order[i];
+            first_in_cell[v] = maps[s].insert(keys[v], v);
+        }
+    });
+
+    // 每个顶点指向本格子的代表顶点；代表顶点再指向周围 26 个相邻格子中距离不超过边长、编号最小的代表顶点，
+    // 检查全部相邻格子，结果与格子划分的位置无关
+    vector<GLuint> remap(vertex_count);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t, size_t first, size_t last) {
+        for (size_t v = first; v < last; ++v) {
+            GLuint best = first_in_cell[v];
+            if (best != v) {
+                remap[v] = best;
+                continue;
+            }
+            int64_t base[3];
+            for (int a = 0; a < 3; ++a) {
+                base[a] = (keys[v] >> (a * CELL_BITS)) & CELL_MASK;
+            }
+            for (int neighbor = 0; neighbor < 27; ++neighbor) {
+                int64_t n[3] = {base[0] + neighbor % 3 - 1, base[1] + neighbor / 3 % 3 - 1, base[2] + neighbor / 9 - 1};
+                if (neighbor == 13 || n[0] < 0 || n[1] < 0 || n[2] < 0) {
+                    continue;
+                }
+                uint64_t key = cell_key(n[0], n[1], n[2]);
+                GLuint other = maps[shard_of(key)].find(key);
+                if (other < best && distance2(other, v) <= cell2) {
+                    best = other;
+                }
+            }
+            remap[v] = best;
+        }
+    });
+
+    // 沿指向编号更小的顶点的链找到最终保留的顶点，结果写回 first_in_cell
+    auto &target = first_in_cell;
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t, size_t first, size_t last) {
+        for (size_t v = first; v < last; ++v) {
+            GLuint t = remap[v];
+            while (remap[t] != t) {
+                t = remap[t];
+            }
+            target[v] = t;
+        }
+    });
+
+    // 保留的顶点按原顺序重新编号，新编号写入 order；先给保留的顶点编号，再让其余顶点沿用其目标的编号
+    auto &id = order;
+    vector<size_t> kept(blocks + 1);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t b, size_t first, size_t last) {
+        for (size_t v = first; v < last; ++v) {
+            kept[b + 1] += target[v] == v;
+        }
+    });
+    for (size_t b = 0; b < blocks; ++b) {
+        kept[b + 1] += kept[b];
+    }
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t b, size_t first, size_t last) {
+        GLuint next = kept[b];
+        for (size_t v = first; v < last; ++v) {
+            if (target[v] == v) {
+                id[v] = next++;
+            }
+        }
+    });
+    bool keep_normals = mesh.normals.size() == mesh.vertices.size();
+    std::pmr::vector<GLfloat> vertices(kept[blocks] * 3), normals(keep_normals ? kept[blocks] * 3 : 0);
+    parallel_blocks(pool, vertex_count, blocks, [&](size_t, size_t first, size_t last) {
+        for (size_t v = first; v < last; ++v) {
+            if (target[v] != v) {
+                id[v] = id[target[v]];
+                continue;
+            }
+            copy_n(position + v * 3, 3, vertices.begin() + size_t(id[v]) * 3);
+            if (keep_normals) {
+                copy_n(mesh.normals.begin() + v * 3, 3, normals.begin() + size_t(id[v]) * 3);
+            }
+        }
+    });
+
+    size_t index_count = mesh.indices.size();
+    parallel_blocks(pool, index_count, block_count(pool, index_count, MIN_WELD_BLOCK),
+                    [&](size_t, size_t first, size_t last) {
+                        for (size_t i = first; i < last; ++i) {
+                            mesh.indices[i] = id[mesh.indices[i]];
+                        }
+                    });
+
+    // 删除有两个角合并到同一顶点的三角形
+    size_t out = 0;
+    for (size_t i = 0; i + 2 < index_count; i += 3) {
+        GLuint a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+        if (a != b && b != c && c != a) {
+            mesh.indices[out++] = a;
+            mesh.indices[out++] = b;
+            mesh.indices[out++] = c;
+        }
+    }
+    mesh.indices.resize(out);
+
+    mesh.vertices = std::move(vertices);
+    mesh.normals  = std::move(normals);
+}
+
+// 生成法向量时每块至少处理的三角形个数
+constexpr size_t MIN_NORMAL_BLOCK = 1 << 14;
+
+// 一批（至多 4 个）三角形的面法向量与三个角的角度，按分量分开存放
+struct TriangleBatch {
+    float nx[4], ny[4], nz[4];
+    float angle[3][4];
+};
+
+// acos 的多项式近似（Abramowitz & Stegun 4.4.45），误差不超过 7e-5 弧度，只用于加权
+constexpr float ACOS_C0 = 1.5707288f, ACOS_C1 = -0.2121144f, ACOS_C2 = 0.0742610f, ACOS_C3 = -0.0187293f;
+constexpr float PI      = 3.14159265f;
+
+#if defined(__SSE2__)
+static __m128 acos_ps(__m128 x) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 ax         = _mm_andnot_ps(sign, x);
+    __m128 poly       = _mm_add_ps(_mm_mul_ps(ax, _mm_set1_ps(ACOS_C3)), _mm_set1_ps(ACOS_C2));
+    poly              = _mm_add_ps(_mm_mul_ps(ax, poly), _mm_set1_ps(ACOS_C1));
+    poly              = _mm_add_ps(_mm_mul_ps(ax, poly), _mm_set1_ps(ACOS_C0));
+    __m128 r          = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), ax)), poly);
+    __m128 negative   = _mm_cmplt_ps(x, _mm_setzero_ps());
+    return _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(PI), r)), _mm_andnot_ps(negative, r));
+}
+
+// 两条边夹角的余弦，限制在 [-1, 1] 内；退化的边得到 NaN 时取 -1
+static __m128 cos_angle_ps(__m128 ux, __m128 uy, __m128 uz, __m128 vx, __m128 vy, __m128 vz) {
+    __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, vx), _mm_mul_ps(uy, vy)), _mm_mul_ps(uz, vz));
+    __m128 uu  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(uy, uy)), _mm_mul_ps(uz, uz));
+    __m128 vv  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+    __m128 c   = _mm_div_ps(dot, _mm_sqrt_ps(_mm_mul_ps(uu, vv)));
+    return _mm_min_ps(_mm_max_ps(c, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+
+// 4 个三角形一组，顶点坐标按分量收集到寄存器中并行计算
+static void triangle_batch(const GLfloat *p, const GLuint *tri, size_t count, TriangleBatch &out) {
+    size_t corner[3][4];
+    for (size_t k = 0; k < 4; ++k) {
+        size_t t = min(k, count - 1); // 不足 4 个时重复最后一个，多出的结果不使用
+        for (int c = 0; c < 3; ++c) {
+            corner[c][k] = size_t(tri[t * 3 + c]) * 3;
+        }
+    }
+    __m128 x[3], y[3], z[3];
+    for (int c = 0; c < 3; ++c) {
+        const size_t *i = corner[c];
+        x[c]            = _mm_setr_ps(p[i[0]], p[i[1]], p[i[2]], p[i[3]]);
+        y[c]            = _mm_setr_ps(p[i[0] + 1], p[i[1] + 1], p[i[2] + 1], p[i[3] + 1]);
+        z[c]            = _mm_setr_ps(p[i[0] + 2], p[i[1] + 2], p[i[2] + 2], p[i[3] + 2]);
+    }
+    __m128 abx = _mm_sub_ps(x[1], x[0]), aby = _mm_sub_ps(y[1], y[0]), abz = _mm_sub_ps(z[1], z[0]);
+    __m128 acx = _mm_sub_ps(x[2], x[0]), acy = _mm_sub_ps(y[2], y[0]), acz = _mm_sub_ps(z[2], z[0]);
+    __m128 bcx = _mm_sub_ps(x[2], x[1]), bcy = _mm_sub_ps(y[2], y[1]), bcz = _mm_sub_ps(z[2], z[1]);
+
+    _mm_storeu_ps(out.nx, _mm_sub_ps(_mm_mul_ps(aby, acz), _mm_mul_ps(abz, acy)));
+    _mm_storeu_ps(out.ny, _mm_sub_ps(_mm_mul_ps(abz, acx), _mm_mul_ps(abx, acz)));
+    _mm_storeu_ps(out.nz, _mm_sub_ps(_mm_mul_ps(abx, acy), _mm_mul_ps(aby, acx)));
+
+    const __m128 zero = _mm_setzero_ps();
+    __m128 a          = acos_ps(cos_angle_ps(abx, aby, abz, acx, acy, acz));
+    __m128 b          = acos_ps(cos_angle_ps(_mm_sub_ps(zero, abx), _mm_sub_ps(zero, aby), _mm_sub_ps(zero, abz), bcx,
+                                             bcy, bcz));
+    _mm_storeu_ps(out.angle[0], a);
+    _mm_storeu_ps(out.angle[1], b);
+    _mm_storeu_ps(out.angle[2], _mm_max_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(PI), a), b), zero));
+}
+#else
+static float acos_approx(float x) {
+    float ax = fabs(x);
+    float r  = sqrt(1.0f - ax) * (ACOS_C0 + ax * (ACOS_C1 + ax * (ACOS_C2 + ax * ACOS_C3)));
+    return x < 0 ? PI - r : r;
+}
+
+static float cos_angle(const float u[3], const float v[3]) {
+    float c = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) /
+              sqrt((u[0] * u[0] + u[1] * u[1] + u[2] * u[2]) * (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+    c = c > -1.0f ? c : -1.0f;
+    return c < 1.0f ? c : 1.0f;
+}
+
+static void triangle_batch(const GLfloat *p, const GLuint *tri, size_t count, TriangleBatch &out) {
+    for (size_t k = 0; k < count; ++k) {
+        const GLfloat *a = p + size_t(tri[k * 3]) * 3, *b = p + size_t(tri[k * 3 + 1]) * 3,
+                      *c = p + size_t(tri[k * 3 + 2]) * 3;
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float bc[3] = {c[0] - b[0], c[1] - b[1], c[2] - b[2]};
+        float ba[3] = {-ab[0], -ab[1], -ab[2]};
+        out.nx[k]   = ab[1] * ac[2] - ab[2] * ac[1];
+        out.ny[k]   = ab[2] * ac[0] - ab[0] * ac[2];
+        out.nz[k]   = ab[0] * ac[1] - ab[1] * ac[0];
+        float angle_a = acos_approx(cos_angle(ab, ac));
+        float angle_b = acos_approx(cos_angle(ba, bc));
+        out.angle[0][k] = angle_a;
+        out.angle[1][k] = angle_b;
+        out.angle[2][k] = max(PI - angle_a - angle_b, 0.0f);
+    }
+}
+#endif
+
+// 归一化 [first, last) 的顶点法向量，长度为零的保持为零
+static void normalize_normals(GLfloat *normals, size_t first, size_t last) {
+    for (size_t v = first; v < last; ++v) {
+        GLfloat *n   = normals + v * 3;
+        float length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0) {
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+        }
+    }
+}
+
+// 索引顺序缺乏局部性时的做法：先求出每个角的加权面法向量，再按顶点→角的 CSR 表逐顶点收集，
+// 不需要原子操作，额外内存与三角形数和顶点数成正比
+static void gather_normals(Mesh<> &mesh, ThreadPool *pool) {
+    size_t vertex_count   = mesh.vertices.size() / 3;
+    size_t triangle_count = mesh.indices.size() / 3;
+    const GLfloat *p      = mesh.vertices.data();
+    const GLuint *indices = mesh.indices.data();
+
+    // 每个角的面法向量（长度为面积的两倍）乘以该角的角度
+    vector<float> corner_normals(triangle_count * 9);
+    parallel_blocks(pool, triangle_count, block_count(pool, triangle_count, MIN_NORMAL_BLOCK),
+                    [&](size_t, size_t first, size_t last) {
+                        TriangleBatch batch;
+                        for (size_t t = first; t < last; t += 4) {
+                            size_t count = min<size_t>(4, last - t);
+                            triangle_batch(p, indices + t * 3, count, batch);
+                            for (size_t k = 0; k < count; ++k) {
+                                for (int c = 0; c < 3; ++c) {
+                                    float *n = corner_normals.data() + ((t + k) * 3 + c) * 3;
+                                    float w  = batch.angle[c][k];
+                                    n[0]     = batch.nx[k] * w;
+                                    n[1]     = batch.ny[k] * w;
+                                    n[2]     = batch.nz[k] * w;
+                                }
+                            }
+                        }
+                    });
+
+    // 顶点→角的 CSR 表，各顶点的角按索引顺序排列
+    vector<GLuint> offsets(vertex_count + 1, 0);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        ++offsets[indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    vector<GLuint> corners(triangle_count * 3);
+    {
+        vector<GLuint> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangle_count * 3; ++i) {
+            corners[cursor[indices[i]]++] = GLuint(i);
+        }
+    }
+
+    mesh.normals.assign(vertex_count * 3, 0.0f);
+    GLfloat *normals = mesh.normals.data();
+    parallel_blocks(pool, vertex_count, block_count(pool, vertex_count, MIN_NORMAL_BLOCK),
+                    [&](size_t, size_t first, size_t last) {
+                        for (size_t v = first; v < last; ++v) {
+                            GLfloat *n = normals + v * 3;
+                            for (GLuint k = offsets[v]; k < offsets[v + 1]; ++k) {
+                                const float *c = corner_normals.data() + size_t(corners[k]) * 3;
+                                n[0] += c[0];
+                                n[1] += c[1];
+                                n[2] += c[2];
+                            }
+                        }
+                        normalize_normals(normals, first, last);
+                    });
+}
+
+void generate_normals(Mesh<> &mesh, ThreadPool *pool) {
+    size_t vertex_count   = mesh.vertices.size() / 3;
+    size_t triangle_count = mesh.indices.size() / 3;
+    const GLfloat *p      = mesh.vertices.data();
+    const GLuint *indices = mesh.indices.data();
+
+    // 每块三角形累加到自己的缓冲区中，避免原子操作；
+    // 缓冲区只覆盖本块引用到的顶点编号范围，按文件顺序排列的网格各块的范围通常很小
+    struct Partial {
+        size_t lo = SIZE_MAX, hi = 0;
+        vector<float> sum;
+    };
+    size_t blocks = block_count(pool, triangle_count, MIN_NORMAL_BLOCK);
+    vector<Partial> partials(blocks);
+    parallel_blocks(pool, triangle_count, blocks, [&](size_t b, size_t first, size_t last) {
+        auto &part = partials[b];
+        for (size_t i = first * 3; i < last * 3; ++i) {
+            part.lo = min<size_t>(part.lo, indices[i]);
+            part.hi = max<size_t>(part.hi, indices[i]);
+        }
+    });
+
+    // 各块范围之和超过顶点数的两倍时（如打乱顺序的网格，每块都几乎覆盖全部顶点）改为按顶点收集，
+    // 使临时内存不超过法向量数组的两倍
+    size_t scratch = 0;
+    for (const auto &part : partials) {
+        scratch += part.lo <= part.hi ? part.hi - part.lo + 1 : 0;
+    }
+    if (scratch > vertex_count * 2) {
+        gather_normals(mesh, pool);
+        return;
+    }
+
+    parallel_blocks(pool, triangle_count, blocks, [&](size_t b, size_t first, size_t last) {
+        auto &part = partials[b];
+        if (first == last) {
+            return;
+        }
+        part.sum.assign((part.hi - part.lo + 1) * 3, 0.0f);
+
+        // 每个角累加面法向量（长度为面积的两倍）乘以该角的角度，即同时按面积和角度加权
+        float *sum = part.sum.data() - part.lo * 3;
+        TriangleBatch batch;
+        for (size_t t = first; t < last; t += 4) {
+            size_t count = min<size_t>(4, last - t);
+            triangle_batch(p, indices + t * 3, count, batch);
+            for (size_t k = 0; k < count; ++k) {
+                for (int c = 0; c < 3; ++c) {
+                    float *n  = sum + size_t(indices[(t + k) * 3 + c]) * 3;
+                    float w   = batch.angle[c][k];
+                    n[0] += batch.nx[k] * w;
+                    n[1] += batch.ny[k] * w;
+                    n[2] += batch.nz[k] * w;
+                }
+            }
+        }
+    });
+
+    // 按顶点分块归约各缓冲区并归一化，未被任何三角形引用的顶点法向量保持为零
+    mesh.normals.assign(vertex_count * 3, 0.0f);
+    GLfloat *normals = mesh.normals.data();
+    parallel_blocks(pool, vertex_count, block_count(pool, vertex_count, MIN_NORMAL_BLOCK),
+                    [&](size_t, size_t first, size_t last) {
+                        for (const auto &part : partials) {
+                            if (part.sum.empty()) {
+                                continue;
+                            }
+                            size_t lo = max(first, part.lo), hi = min(last, part.hi + 1);
+                            for (size_t i = lo * 3; i < hi * 3; ++i) {
+                                normals[i] += part.sum[i - part.lo * 3];
+                            }
+                        }
+                        normalize_normals(normals, first, last);
+                    });
+}
+
+void fill_missing_normals(Mesh<> &mesh, ThreadPool *pool) {
+    vector<GLfloat> given(mesh.normals.begin(), mesh.normals.end());
+    generate_normals(mesh, pool);
+    for (size_t i = 0; i < given.size(); i += 3) {
+        if (given[i] != 0.0f || given[i + 1] != 0.0f || given[i + 2] != 0.0f) {
+            copy_n(given.begin() + i, 3, mesh.normals.begin() + i);
+        }
+    }
+}
+
+VertexCacheStats analyze_vertex_cache(const Mesh<> &mesh, unsigned cache_size) {
+    size_t vertex_count = mesh.vertices.size() / 3;
+    // 每个顶点最近一次进入缓存的时间；当前时间与之相差不超过 cache_size 即仍在 FIFO 缓存中
+    vector<size_t> cached_at(vertex_count, 0);
+    vector<bool> referenced(vertex_count, false);
+    size_t time = cache_size + 1, misses = 0, used = 0;
+    for (GLuint v : mesh.indices) {
+        if (time - cached_at[v] > cache_size) {
+            cached_at[v] = time++;
+            ++misses;
+        }
+        if (!referenced[v]) {
+            referenced[v] = true;
+            ++used;
+        }
+    }
+    size_t triangles = mesh.indices.size() / 3;
+    return {triangles ? double(misses) / triangles : 0.0, used ? double(misses) / used : 0.0};
+}
+
+// 对 triangle_count 个三角形（顶点编号为 [0, vertex_count) 内的局部编号）执行 Tipsify，
+// 把三角形的输出顺序写入 order
+// 参见 Sander, Nehab, Barczak. Fast Triangle Reordering for Vertex Locality and Reduced Overdraw. 2007
+static void tipsify(const GLuint *indices, size_t triangle_count, size_t vertex_count, unsigned cache_size,
+                    vector<GLuint> &order) {
+    // 顶点到三角形的邻接表（CSR），live 为尚未输出的相邻三角形数
+    vector<GLuint> offset(vertex_count + 1, 0), live(vertex_count, 0);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        ++live[indices[i]];
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        offset[v + 1] = offset[v] + live[v];
+    }
+    vector<GLuint> adjacency(triangle_count * 3), fill(offset.begin(), offset.end() - 1);
+    for (size_t i = 0; i < triangle_count * 3; ++i) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    vector<size_t> cached_at(vertex_count, 0);
+    vector<bool> emitted(triangle_count, false);
+    vector<GLuint> dead_end, candidates;
+    size_t time = cache_size + 1;
+    size_t scan = 0; // 找不到候选顶点时按编号顺序继续查找的位置
+
+    order.clear();
+    order.reserve(triangle_count);
+    for (int64_t fan = vertex_count ? 0 : -1; fan >= 0;) {
+        // 输出以 fan 为中心的所有未输出三角形
+        candidates.clear();
+        for (GLuint k = offset[fan]; k < offset[fan + 1]; ++k) {
+            GLuint t = adjacency[k];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            order.push_back(t);
+            for (int c = 0; c < 3; ++c) {
+                GLuint v = indices[size_t(t) * 3 + c];
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cached_at[v] > cache_size) {
+                    cached_at[v] = time++;
+                }
+            }
+        }
+
+        // 选择仍在缓存中、且输出其剩余三角形后大概率不会被挤出缓存的候选顶点，越早进入缓存越优先
+        fan           = -1;
+        int64_t score = 0;
+        for (GLuint v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cached_at[v] + 2 * size_t(live[v]) <= cache_size) {
+                priority = time - cached_at[v];
+            }
+            if (priority > score) {
+                score = priority;
+                fan   = v;
+            }
+        }
+        // 候选顶点都已用完时，先从最近输出的顶点中回溯，再按编号顺序查找
+        while (fan < 0 && !dead_end.empty()) {
+            GLuint v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v] > 0) {
+                fan = v;
+            }
+        }
+        for (; fan < 0 && scan < vertex_count; ++scan) {
+            if (live[scan] > 0) {
+                fan = scan;
+            }
+        }
+    }
+}
+
+// 并行重排时每段至少包含的三角形个数
+constexpr size_t MIN_REORDER_BLOCK = 1 << 16;
+
+void optimize_vertex_cache(Mesh<> &mesh, ThreadPool *pool, unsigned cache_size) {
+    size_t triangle_count = mesh.indices.size() / 3;
+    size_t blocks         = block_count(pool, triangle_count, MIN_REORDER_BLOCK);
+    std::vector<GLuint> reordered(triangle_count * 3);
+
+    // 各段把顶点编号映射为段内按首次出现顺序的局部编号，邻接表只需覆盖本段用到的顶点
+    parallel_blocks(pool, triangle_count, blocks, [&](size_t, size_t first, size_t last) {
+        const GLuint *indices = mesh.indices.data() + first * 3;
+        size_t count          = last - first;
+        OpenHashMap local_id(count);
+        vector<GLuint> local(count * 3), global;
+        for (size_t i = 0; i < count * 3; ++i) {
+            GLuint id = local_id.insert(indices[i], global.size());
+            if (id == global.size()) {
+                global.push_back(indices[i]);
+            }
+            local[i] = id;
+        }
+
+        vector<GLuint> order;
+        tipsify(local.data(), count, global.size(), cache_size, order);
+        GLuint *out = reordered.data() + first * 3;
+        for (size_t k = 0; k < count; ++k) {
+            copy_n(indices + size_t(order[k]) * 3, 3, out + k * 3);
+        }
+    });
+
+    copy(reordered.begin(), reordered.end(), mesh.indices.begin());
+}
+
+// 把 data 中的第 i 个三元组移动到第 new_id[i] 个位置，沿置换的环依次交换，只需一个标记数组
+static void permute_triples(GLfloat *data, const vector<GLuint> &new_id) {
+    vector<bool> placed(new_id.size(), false);
+    for (size_t start = 0; start < new_id.size(); ++start) {
+        if (placed[start]) {
+            continue;
+        }
+        GLfloat carried[3] = {data[start * 3], data[start * 3 + 1], data[start * 3 + 2]};
+        size_t i           = start;
+        do {
+            i = new_id[i];
+            for (int a = 0; a < 3; ++a) {
+                swap(carried[a], data[i * 3 + a]);
+            }
+            placed[i] = true;
+        } while (i != start);
+    }
+}
+
+void optimize_vertex_fetch(Mesh<> &mesh) {
+    size_t vertex_count = mesh.vertices.size() / 3;
+    constexpr GLuint UNUSED = ~GLuint(0);
+    vector<GLuint> new_id(vertex_count, UNUSED);
+    GLuint next = 0;
+    for (auto &v : mesh.indices) {
+        if (new_id[v] == UNUSED) {
+            new_id[v] = next++;
+        }
+        v = new_id[v];
+    }
+    for (auto &id : new_id) {
+        if (id == UNUSED) {
+            id = next++;
+        }
+    }
+
+    permute_triples(mesh.vertices.data(), new_id);
+    if (mesh.normals.size() == mesh.vertices.size()) {
+        permute_triples(mesh.normals.data(), new_id);
+    }
+}
+
+template <typename index>
+std::vector<InterleavedVertex> interleave_vertices(const Mesh<GLfloat, index> &mesh) {
+    size_t vertex_count = mesh.vertices.size() / 3;
+    bool has_normals    = mesh.normals.size() == mesh.vertices.size();
+    std::vector<InterleavedVertex> interleaved(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        copy_n(mesh.vertices.begin() + v * 3, 3, interleaved[v].position);
+        if (has_normals) {
+            copy_n(mesh.normals.begin() + v * 3, 3, interleaved[v].normal);
+        } else {
+            fill_n(interleaved[v].normal, 3, 0.0f);
+        }
+    }
+    return interleaved;
+}
+
+template std::vector<InterleavedVertex> interleave_vertices(const Mesh<GLfloat, GLuint> &mesh);
+template std::vector<InterleavedVertex> interleave_vertices(const Mesh<GLfloat, GLushort> &mesh);
+
+std::vector<SubMesh> split_mesh_16(const Mesh<> &mesh, Mesh<GLfloat, GLushort> &out,
+                                   const std::vector<std::vector<GLuint>> &lods) {
+    size_t vertex_count = mesh.vertices.size() / 3;
+    bool has_normals    = mesh.normals.size() == mesh.vertices.size();
+
+    // mesh.indices 之后依次接上各级 LOD 的索引
+    vector<pair<const GLuint *, size_t>> sources = {{mesh.indices.data(), mesh.indices.size()}};
+    for (const auto &lod : lods) {
+        sources.push_back({lod.data(), lod.size()});
+    }
+    size_t total_indices = 0;
+    for (auto [data, size] : sources) {
+        total_indices += size;
+    }
+    out.indices.resize(total_indices);
+
+    if (vertex_count <= MAX_SUBMESH_VERTICES) {
+        out.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+        out.normals.assign(mesh.normals.begin(), mesh.normals.end());
+        auto it = out.indices.begin();
+        for (auto [data, size] : sources) {
+            it = copy(data, data + size, it);
+        }
+        return {{0, vertex_count, 0, total_indices}};
+    }
+
+    // 依次把三角形放入当前子网格，新引用的顶点会使其超出上限时开始下一个子网格
+    constexpr GLuint NONE = ~GLuint(0);
+    vector<GLuint> owner(vertex_count, NONE); // 顶点最近一次复制到的子网格
+    vector<GLushort> local(vertex_count);     // 顶点在该子网格中的编号
+    vector<SubMesh> parts;
+    SubMesh part{0, 0, 0, 0};
+    out.vertices.clear();
+    out.normals.clear();
+    size_t i = 0; // 在 out.indices 中的位置
+    for (auto [data, size] : sources) {
+        for (size_t k = 0; k < size; k += 3, i += 3) {
+            const GLuint *tri = data + k;
+            GLuint id         = parts.size();
+            size_t added      = (owner[tri[0]] != id) + (owner[tri[1]] != id && tri[1] != tri[0]) +
+                           (owner[tri[2]] != id && tri[2] != tri[0] && tri[2] != tri[1]);
+            if (part.vertex_count + added > MAX_SUBMESH_VERTICES) {
+                part.index_count = i - part.first_index;
+                parts.push_back(part);
+                part = {out.vertices.size() / 3, 0, i, 0};
+                ++id;
+            }
+            for (int c = 0; c < 3; ++c) {
+                GLuint v = tri[c];
+                if (owner[v] != id) {
+                    owner[v] = id;
+                    local[v] = part.vertex_count++;
+                    out.vertices.insert(out.vertices.end(), mesh.vertices.begin() + v * 3,
+                                        mesh.vertices.begin() + v * 3 + 3);
+                    if (has_normals) {
+                        out.normals.insert(out.normals.end(), mesh.normals.begin() + v * 3,
+                                           mesh.normals.begin() + v * 3 + 3);
+                    }
+                }
+                out.indices[i + c] = local[v];
+            }
+        }
+    }
+    part.index_count = total_indices - part.first_index;
+    parts.push_back(part);
+    return parts;
+}
+
+// 二次误差度量：对称 4x4 矩阵的上三角部分，error(p) = [p 1] A [p 1]^T
+// 元素依次为 a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+struct Quadric {
+    double a[10] = {};
+
+    // 加上到平面 n·p + d = 0 距离平方的 w 倍
+    void add_plane(const double n[3], double d, double w) {
+        const double v[4] = {n[0], n[1], n[2], d};
+        int k             = 0;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = r; c < 4; ++c) {
+                a[k++] += w * v[r] * v[c];
+            }
+        }
+    }
+    void add(const Quadric &q) {
+        for (int k = 0; k < 10; ++k) {
+            a[k] += q.a[k];
+        }
+    }
+    double error(const GLfloat *p) const {
+        double x = p[0], y = p[1], z = p[2];
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x + a[4] * y * y + 2 * a[5] * y * z +
+               2 * a[6] * y + a[7] * z * z + 2 * a[8] * z + a[9];
+    }
+};
+
+// 边界边约束平面的权重，相对于面片平面的误差，使边界不易收缩
+constexpr double BOUNDARY_WEIGHT = 10.0;
+
+static void sub3(const GLfloat *a, const GLfloat *b, double out[3]) {
+    for (int k = 0; k < 3; ++k) {
+        out[k] = double(a[k]) - b[k];
+    }
+}
+
+static void cross3(const double u[3], const double v[3], double out[3]) {
+    out[0] = u[1] * v[2] - u[2] * v[1];
+    out[1] = u[2] * v[0] - u[0] * v[2];
+    out[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+static double dot3(const double u[3], const double v[3]) {
+    return u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+}
+
+// 三角形 (a, b, c) 的法向量（未单位化，长度为面积的两倍）
+static void face_normal(const GLfloat *a, const GLfloat *b, const GLfloat *c, double n[3]) {
+    double e1[3], e2[3];
+    sub3(b, a, e1);
+    sub3(c, a, e2);
+    cross3(e1, e2, n);
+}
+
+// 顶点到所在三角形的 CSR 邻接表：顶点 v 所在的三角形为 adjacent[offsets[v] .. offsets[v + 1])
+static void triangle_adjacency(const GLuint *indices, size_t index_count, size_t vertex_count, vector<GLuint> &offsets,
+                               vector<GLuint> &adjacent) {
+    offsets.assign(vertex_count + 1, 0);
+    for (size_t i = 0; i < index_count; ++i) {
+        ++offsets[indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+    adjacent.resize(index_count);
+    for (size_t i = 0; i < index_count; ++i) {
+        adjacent[fill[indices[i]]++] = i / 3;
+    }
+}
+
+// 按高 32 位升序排列，低 32 位不参与比较；三趟 LSD 基数排序，每趟 11 位
+static void radix_sort_high(vector<uint64_t> &keys) {
+    constexpr int RADIX_BITS = 11;
+    constexpr size_t BUCKETS = size_t(1) << RADIX_BITS;
+    vector<uint64_t> temp(keys.size());
+    for (int shift = 32; shift < 64; shift += RADIX_BITS) {
+        size_t offsets[BUCKETS] = {};
+        for (auto key : keys) {
+            ++offsets[(key >> shift) & (BUCKETS - 1)];
+        }
+        size_t sum = 0;
+        for (auto &offset : offsets) {
+            sum += exchange(offset, sum);
+        }
+        for (auto key : keys) {
+            temp[offsets[(key >> shift) & (BUCKETS - 1)]++] = key;
+        }
+        keys.swap(temp);
+    }
+}
+
+// 每个顶点的初始误差：相邻面片平面按面积加权，边界边另加垂直于面片、过该边的约束平面
+static vector<Quadric> vertex_quadrics(const Mesh<> &mesh) {
+    const GLfloat *p = mesh.vertices.data();
+    vector<Quadric> quadrics(mesh.vertices.size() / 3);
+
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const GLuint *tri = &mesh.indices[i];
+        double n[3];
+        face_normal(p + tri[0] * 3, p + tri[1] * 3, p + tri[2] * 3, n);
+        double len = sqrt(dot3(n, n));
+        if (len == 0.0) {
+            continue;
+        }
+        for (auto &x : n) {
+            x /= len;
+        }
+        double d = -(n[0] * p[tri[0] * 3] + n[1] * p[tri[0] * 3 + 1] + n[2] * p[tri[0] * 3 + 2]);
+        for (int c = 0; c < 3; ++c) {
+            quadrics[tri[c]].add_plane(n, d, len * 0.5);
+        }
+    }
+
+    // 没有相邻三角形包含反向边 b -> a 的边 a -> b 是边界边
+    vector<GLuint> offsets, adjacent;
+    triangle_adjacency(mesh.indices.data(), mesh.indices.size(), quadrics.size(), offsets, adjacent);
+    auto has_edge = [&](GLuint a, GLuint b) {
+        for (GLuint k = offsets[a]; k < offsets[a + 1]; ++k) {
+            const GLuint *t = &mesh.indices[adjacent[k] * 3];
+            if ((t[0] == a && t[1] == b) || (t[1] == a && t[2] == b) || (t[2] == a && t[0] == b)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const GLuint *tri = &mesh.indices[i];
+        for (int c = 0; c < 3; ++c) {
+            GLuint a = tri[c], b = tri[(c + 1) % 3];
+            if (has_edge(b, a)) {
+                continue;
+            }
+            double n[3], e[3], m[3];
+            face_normal(p + tri[0] * 3, p + tri[1] * 3, p + tri[2] * 3, n);
+            sub3(p + b * 3, p + a * 3, e);
+            cross3(e, n, m);
+            double len = sqrt(dot3(m, m));
+            if (len == 0.0) {
+                continue;
+            }
+            for (auto &x : m) {
+                x /= len;
+            }
+            double d = -(m[0] * p[a * 3] + m[1] * p[a * 3 + 1] + m[2] * p[a * 3 + 2]);
+            double w = dot3(e, e) * BOUNDARY_WEIGHT;
+            quadrics[a].add_plane(m, d, w);
+            quadrics[b].add_plane(m, d, w);
+        }
+    }
+    return quadrics;
+}
+
+// 一轮边折叠：按误差从小到大折叠互不相邻的边，直到预计的三角形数降到 target
+// 每次折叠把一个顶点移到相邻顶点上，使相邻三角形翻转的折叠被跳过；返回是否发生了折叠
+static bool collapse_pass(const GLfloat *p, vector<Quadric> &quadrics, vector<GLuint> &indices, size_t target) {
+    size_t vertex_count   = quadrics.size();
+    size_t triangle_count = indices.size() / 3;
+
+    vector<GLuint> offsets, adjacent;
+    triangle_adjacency(indices.data(), indices.size(), vertex_count, offsets, adjacent);
+
+    // 每条半边取误差较小的折叠方向；内部边会出现两次，重复的候选在折叠时因顶点已锁定而被跳过
+    struct Collapse {
+        GLuint from, to;
+    };
+    vector<Collapse> collapses(indices.size());
+    vector<uint64_t> order(indices.size()); // 高 32 位为误差（非负 float 的位模式保持大小顺序），低 32 位为候选编号
+    for (size_t i = 0; i < indices.size(); ++i) {
+        GLuint a = indices[i], b = indices[i - i % 3 + (i + 1) % 3];
+        double to_b  = quadrics[a].error(p + b * 3) + quadrics[b].error(p + b * 3);
+        double to_a  = quadrics[a].error(p + a * 3) + quadrics[b].error(p + a * 3);
+        collapses[i] = to_b <= to_a ? Collapse{a, b} : Collapse{b, a};
+        float cost   = float(max(0.0, min(to_a, to_b)));
+        uint32_t bits;
+        memcpy(&bits, &cost, sizeof(bits));
+        order[i] = uint64_t(bits) << 32 | i;
+    }
+    radix_sort_high(order);
+
+    // 被折叠顶点所在三角形的顶点本轮都不再移动，保证翻转检查使用的位置不变
+    vector<bool> locked(vertex_count, false);
+    vector<GLuint> remap(vertex_count);
+    iota(remap.begin(), remap.end(), GLuint(0));
+    size_t removed  = 0;
+    bool collapsed  = false;
+    auto flips      = [&](GLuint from, GLuint to) {
+        for (GLuint k = offsets[from]; k < offsets[from + 1]; ++k) {
+            const GLuint *tri = &indices[adjacent[k] * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                continue;
+            }
+            const GLfloat *q[3], *moved[3];
+            for (int c = 0; c < 3; ++c) {
+                q[c]     = p + tri[c] * 3;
+                moved[c] = tri[c] == from ? p + to * 3 : q[c];
+            }
+            double before[3], after[3];
+            face_normal(q[0], q[1], q[2], before);
+            face_normal(moved[0], moved[1], moved[2], after);
+            if (dot3(before, after) <= 0.0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (auto key : order) {
+        const Collapse &c = collapses[GLuint(key)];
+        if (triangle_count - removed <= target) {
+            break;
+        }
+        if (locked[c.from] || locked[c.to] || flips(c.from, c.to)) {
+            continue;
+        }
+        remap[c.from] = c.to;
+        quadrics[c.to].add(quadrics[c.from]);
+        for (GLuint k = offsets[c.from]; k < offsets[c.from + 1]; ++k) {
+            const GLuint *tri = &indices[adjacent[k] * 3];
+            for (int v = 0; v < 3; ++v) {
+                locked[tri[v]] = true;
+            }
+            removed += tri[0] == c.to || tri[1] == c.to || tri[2] == c.to;
+        }
+        collapsed = true;
+    }
+    if (!collapsed) {
+        return false;
+    }
+
+    // 改写索引并删除退化的三角形
+    size_t kept = 0;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        GLuint a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a == b || b == c || a == c) {
+            continue;
+        }
+        indices[kept++] = a;
+        indices[kept++] = b;
+        indices[kept++] = c;
+    }
+    indices.resize(kept);
+    return true;
+}
+
+std::vector<std::vector<GLuint>> build_lod_chain(const Mesh<> &mesh, std::initializer_list<float> ratios) {
+    vector<Quadric> quadrics = vertex_quadrics(mesh);
+    vector<GLuint> indices(mesh.indices.begin(), mesh.indices.end());
+    size_t triangle_count = mesh.indices.size() / 3;
+
+    // 每一级都从上一级继续折叠，各级误差依次累积
+    std::vector<std::vector<GLuint>> levels;
+    for (float ratio : ratios) {
+        size_t target = size_t(triangle_count * ratio);
+        while (indices.size() / 3 > target && collapse_pass(mesh.vertices.data(), quadrics, indices, target)) {
+        }
+        levels.push_back(indices);
+    }
+    return levels;
+}
+
+std::vector<Meshlet> build_meshlets(const Mesh<> &mesh) {
+    const GLfloat *p      = mesh.vertices.data();
+    size_t vertex_count   = mesh.vertices.size() / 3;
+    constexpr GLuint NONE = ~GLuint(0);
+    vector<GLuint> owner(vertex_count, NONE); // 顶点最近一次加入的 meshlet
+    vector<GLuint> members;                   // 当前 meshlet 的顶点
+    vector<Meshlet> meshlets;
+
+    // 由 [first, last) 的三角形及其顶点计算包围球和法向锥
+    auto finish = [&](size_t first, size_t last) {
+        Meshlet m{first, last - first, {}, 0.0f, {}, 1.0f};
+        GLfloat lo[3], hi[3];
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = hi[a] = p[members[0] * 3 + a];
+        }
+        for (auto v : members) {
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = min(lo[a], p[v * 3 + a]);
+                hi[a] = max(hi[a], p[v * 3 + a]);
+            }
+        }
+        for (int a = 0; a < 3; ++a) {
+            m.center[a] = (lo[a] + hi[a]) * 0.5f;
+        }
+        double r2 = 0.0;
+        for (auto v : members) {
+            double d[3];
+            sub3(p + v * 3, m.center, d);
+            r2 = max(r2, dot3(d, d));
+        }
+        m.radius = sqrt(r2);
+
+        // 法向锥：单位面法向量之和的方向，张角由与它夹角最大的面法向量决定
+        vector<array<double, 3>> normals;
+        double axis[3] = {0.0, 0.0, 0.0};
+        for (size_t i = first; i < last; i += 3) {
+            array<double, 3> n;
+            face_normal(p + mesh.indices[i] * 3, p + mesh.indices[i + 1] * 3, p + mesh.indices[i + 2] * 3, n.data());
+            double len = sqrt(dot3(n.data(), n.data()));
+            if (len == 0.0) {
+                continue;
+            }
+            for (int a = 0; a < 3; ++a) {
+                n[a] /= len;
+                axis[a] += n[a];
+            }
+            normals.push_back(n);
+        }
+        double len = sqrt(dot3(axis, axis));
+        if (len > 0.0) {
+            double min_dot = 1.0;
+            for (int a = 0; a < 3; ++a) {
+                axis[a] /= len;
+                m.cone_axis[a] = axis[a];
+            }
+            for (const auto &n : normals) {
+                min_dot = min(min_dot, dot3(n.data(), axis));
+            }
+            m.cone_cutoff = min_dot <= 0.0 ? 1.0f : float(sqrt(1.0 - min_dot * min_dot));
+        }
+        meshlets.push_back(m);
+        members.clear();
+    };
+
+    size_t first = 0;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const GLuint *tri = &mesh.indices[i];
+        GLuint id         = meshlets.size();
+        size_t added      = (owner[tri[0]] != id) + (owner[tri[1]] != id && tri[1] != tri[0]) +
+                       (owner[tri[2]] != id && tri[2] != tri[0] && tri[2] != tri[1]);
+        if (members.size() + added > MESHLET_MAX_VERTICES || (i - first) / 3 == MESHLET_MAX_TRIANGLES) {
+            finish(first, i);
+            first = i;
+            ++id;
+        }
+        for (int c = 0; c < 3; ++c) {
+            if (owner[tri[c]] != id) {
+                owner[tri[c]] = id;
+                members.push_back(tri[c]);
+            }
+        }
+    }
+    if (first < mesh.indices.size()) {
+        finish(first, mesh.indices.size());
+    }
+    return meshlets;
+}
+
+// 剔除时每块至少处理的 meshlet 个数
+constexpr size_t MIN_CULL_BLOCK = 1 << 10;
+
+CullStats cull_meshlets(const std::vector<Meshlet> &meshlets, const CullView &view,
+                        std::vector<std::pair<size_t, size_t>> &ranges, ThreadPool *pool) {
+    enum : unsigned char { VISIBLE, OUTSIDE, BACKFACING };
+    vector<unsigned char> result(meshlets.size());
+    parallel_blocks(pool, meshlets.size(), block_count(pool, meshlets.size(), MIN_CULL_BLOCK),
+                    [&](size_t, size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; ++i) {
+                            const Meshlet &m = meshlets[i];
+                            result[i]        = VISIBLE;
+                            for (const auto &plane : view.planes) {
+                                float distance = plane[0] * m.center[0] + plane[1] * m.center[1] +
+                                                 plane[2] * m.center[2] + plane[3];
+                                float scale = sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+                                if (distance < -m.radius * scale) {
+                                    result[i] = OUTSIDE;
+                                    break;
+                                }
+                            }
+                            if (result[i] != VISIBLE) {
+                                continue;
+                            }
+                            // 包围球内任意一点看到的面都不朝向观察点时整体背向
+                            float d[3] = {m.center[0] - view.eye[0], m.center[1] - view.eye[1],
+                                          m.center[2] - view.eye[2]};
+                            float distance = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+                            float along    = d[0] * m.cone_axis[0] + d[1] * m.cone_axis[1] + d[2] * m.cone_axis[2];
+                            if (along >= m.cone_cutoff * distance + m.radius) {
+                                result[i] = BACKFACING;
+                            }
+                        }
+                    });
+
+    CullStats stats{0, 0, 0, 0};
+    ranges.clear();
+    for (size_t i = 0; i < meshlets.size(); ++i) {
+        const Meshlet &m = meshlets[i];
+        if (result[i] != VISIBLE) {
+            ++(result[i] == OUTSIDE ? stats.frustum_culled : stats.backface_culled);
+            stats.culled_triangles += m.index_count / 3;
+            continue;
+        }
+        ++stats.visible;
+        if (!ranges.empty() && ranges.back().first + ranges.back().second == m.first_index) {
+            ranges.back().second += m.index_count;
+        } else {
+            ranges.push_back({m.first_index, m.index_count});
+        }
+    }
+    return stats;
+}
+
+}; // namespace glss
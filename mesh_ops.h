@@ -0,0 +1,130 @@
+#ifndef MESH_OPS_H__
+#define MESH_OPS_H__
+
+#include "thread_pool.h"
+#include "utils.h"
+
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+inline namespace glss {
+
+// 顶点和法向量各自独立索引时，把 (顶点索引, 法向量索引) 相同的角合并为同一个顶点，
+// 重建 vertices、normals 并改写 indices，使二者可按同一索引上传到 VBO/NBO
+// normal_indices 与 mesh.indices 一一对应，越界的法向量索引表示该角没有法向量，其法向量置零，可再由 fill_missing_normals 补算
+void weld_vertex_normals(Mesh<> &mesh, const std::vector<GLuint> &normal_indices);
+
+// 用空间网格散列合并位置相近的顶点，并改写 indices、删除因此退化的三角形
+// 网格边长为 epsilon 乘以包围盒对角线长度（过小时会被放大，使每个轴上的格子数不超过 2^21）；
+// 落在同一格子中的顶点合并为编号最小的那个，相邻格子的这一顶点距离不超过边长时两个格子也合并
+// normals 与 vertices 一一对应时保留被保留顶点的法向量，否则清空
+// pool 为空时串行执行，结果与线程数无关
+void weld_positions(Mesh<> &mesh, float epsilon, ThreadPool *pool = nullptr);
+
+// 由三角形计算顶点法向量，覆盖原有的 normals：每个角累加面法向量，按面片面积与该角的角度加权
+// pool 不为空时各块三角形并行累加到各自只覆盖所引用顶点范围的缓冲区，再按顶点分块归约；
+// 各块范围之和超过顶点数两倍时（索引顺序缺乏局部性）改为按顶点→角的 CSR 表逐顶点收集，临时内存为 O(V + T)
+void generate_normals(Mesh<> &mesh, ThreadPool *pool = nullptr);
+
+// 只为法向量为零的顶点（如合并后没有法向量的角）按 generate_normals 的方法计算法向量，其余顶点保持不变
+void fill_missing_normals(Mesh<> &mesh, ThreadPool *pool = nullptr);
+
+// 顶点变换缓存的模拟大小（FIFO）
+constexpr unsigned VERTEX_CACHE_SIZE = 16;
+
+// 以 FIFO 缓存模拟按 indices 顺序绘制时的顶点缓存命中情况
+struct VertexCacheStats {
+    double acmr; // 每个三角形平均的缓存未命中次数
+    double atvr; // 未命中次数与被引用顶点数之比，理想值为 1
+};
+VertexCacheStats analyze_vertex_cache(const Mesh<> &mesh, unsigned cache_size = VERTEX_CACHE_SIZE);
+
+// 用 Tipsify 算法重排三角形顺序以提高顶点缓存命中率，三角形集合及每个三角形的顶点顺序（绕向）不变
+// pool 不为空时把三角形按原顺序切分为若干段，各段独立并行重排后依次拼接
+void optimize_vertex_cache(Mesh<> &mesh, ThreadPool *pool = nullptr, unsigned cache_size = VERTEX_CACHE_SIZE);
+
+// 按顶点在 indices 中首次出现的顺序重新编号，使绘制时基本按顺序读取顶点数据，未被引用的顶点排在最后
+// vertices 与 normals（与顶点一一对应时）原地重排，不重新分配内存；应在 optimize_vertex_cache 之后调用
+void optimize_vertex_fetch(Mesh<> &mesh);
+
+// 位置与法向量交错存放的顶点，读取一个顶点的全部属性只需访问一处内存
+struct InterleavedVertex {
+    GLfloat position[3];
+    GLfloat normal[3];
+};
+
+// 把 vertices 与 normals 合并为交错数组，法向量与顶点不一一对应时法向量置零
+// 对 GLuint 与 GLushort 两种索引类型的网格提供实现
+template <typename index>
+std::vector<InterleavedVertex> interleave_vertices(const Mesh<GLfloat, index> &mesh);
+
+// 索引类型对应的 glDrawElements 类型参数
+template <typename index>
+constexpr GLenum gl_index_type = GL_UNSIGNED_INT;
+template <>
+constexpr GLenum gl_index_type<GLushort> = GL_UNSIGNED_SHORT;
+
+// 16 位索引的子网格最多包含的顶点数，0xFFFF 留作图元重启索引
+constexpr size_t MAX_SUBMESH_VERTICES = 65535;
+
+// 子网格：indices 中 [first_index, first_index + index_count) 的索引引用
+// vertices 中从 first_vertex 开始的 vertex_count 个顶点，索引值相对于 first_vertex
+struct SubMesh {
+    size_t first_vertex;
+    size_t vertex_count;
+    size_t first_index;
+    size_t index_count;
+};
+
+// 转换为 16 位索引：顶点数不超过 MAX_SUBMESH_VERTICES 时只有一个子网格，顶点数据与编号不变；
+// 否则按三角形顺序切分为连续的若干段，每段的顶点依次复制到 out 中（段间共用的顶点会重复）
+// 三角形顺序不变，第 t 个三角形的索引在 out.indices 中仍位于 3t；lods 中各级的索引依次接在 mesh.indices 之后
+std::vector<SubMesh> split_mesh_16(const Mesh<> &mesh, Mesh<GLfloat, GLushort> &out,
+                                   const std::vector<std::vector<GLuint>> &lods = {});
+
+// 用二次误差度量的边折叠依次简化出三角形数约为原网格 ratios 倍的各级 LOD
+// 顶点只会折叠到相邻的已有顶点上，各级索引都引用原有的 vertices，可与原网格共用顶点缓冲区
+// 跳过使三角形翻转的折叠，无法继续折叠时该级的三角形数可能多于目标
+std::vector<std::vector<GLuint>> build_lod_chain(const Mesh<> &mesh,
+                                                 std::initializer_list<float> ratios = {0.5f, 0.25f, 0.1f});
+
+// meshlet 的顶点数与三角形数上限
+constexpr size_t MESHLET_MAX_VERTICES  = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+// meshlet：indices 中 [first_index, first_index + index_count) 的连续三角形，附带用于剔除的包围球和法向锥
+struct Meshlet {
+    size_t first_index;
+    size_t index_count;
+    GLfloat center[3]; // 包围球
+    GLfloat radius;
+    GLfloat cone_axis[3]; // 面法向量的平均方向
+    GLfloat cone_cutoff;  // 面法向量偏离 cone_axis 最大角度的正弦，法向量分布超过半球时为 1（不做背面剔除）
+};
+
+// 按 indices 的顺序把三角形依次划分为 meshlet，应在 optimize_vertex_cache 之后调用以使每个 meshlet 紧凑
+std::vector<Meshlet> build_meshlets(const Mesh<> &mesh);
+
+// 剔除使用的视锥体平面与观察点，均在模型坐标系中
+// 平面 (a, b, c, d) 的内侧满足 a x + b y + c z + d >= 0，(a, b, c) 不必单位化
+struct CullView {
+    GLfloat planes[6][4];
+    GLfloat eye[3];
+};
+
+struct CullStats {
+    size_t visible;          // 可见的 meshlet 数
+    size_t frustum_culled;   // 在视锥体外的 meshlet 数
+    size_t backface_culled;  // 全部背向观察点的 meshlet 数
+    size_t culled_triangles; // 被剔除的三角形数
+};
+
+// 剔除视锥体外和全部背向观察点的 meshlet，把相邻的可见 meshlet 合并为 (起始位置, 索引个数) 的区间写入 ranges
+// pool 不为空时各块 meshlet 并行判断
+CullStats cull_meshlets(const std::vector<Meshlet> &meshlets, const CullView &view,
+                        std::vector<std::pair<size_t, size_t>> &ranges, ThreadPool *pool = nullptr);
+
+} // namespace glss
+
+#endif
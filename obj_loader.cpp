@@ -0,0 +1,454 @@
+#include <GL/glew.h>
+
+#include "mapped_file.h"
+#include "mesh_loader.h"
+#include "mesh_ops.h"
+#include "text_scan.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+
+using namespace std;
+
+namespace glss {
+
+template <typename T, typename A>
+static inline const char *parse_vec3(const char *p, const char *end, std::vector<T, A> &out) {
+    float x, y, z;
+    if (!(p = parse_float(p, end, x)) || !(p = parse_float(p, end, y)) || !(p = parse_float(p, end, z))) {
+        return nullptr;
+    }
+    out.push_back(x);
+    out.push_back(y);
+    out.push_back(z);
+    return p;
+}
+
+// 解析一个非零整数索引，负数表示相对于当前已定义数量的索引
+static inline const char *parse_index(const char *p, const char *end, int64_t &i) {
+    auto [ptr, ec] = from_chars(p, end, i);
+    return ec == errc() && i != 0 ? ptr : nullptr;
+}
+
+// 面片一个角的各项索引，0 表示缺省
+struct ObjCorner {
+    int64_t v, vt, vn;
+};
+
+// 以状态机解析面片的一个角：v、v/vt、v//vn 或 v/vt/vn
+static inline const char *parse_corner(const char *p, const char *end, ObjCorner &corner) {
+    corner = {0, 0, 0};
+    if (!(p = parse_index(p, end, corner.v))) {
+        return nullptr;
+    }
+    if (p < end && *p == '/') {
+        ++p;
+        // 纹理坐标索引可以为空，形如 v//vn
+        if (p < end && *p != '/' && !(p = parse_index(p, end, corner.vt))) {
+            return nullptr;
+        }
+        if (p < end && *p == '/' && !(p = parse_index(p + 1, end, corner.vn))) {
+            return nullptr;
+        }
+    }
+    // 行尾注释可以紧跟在角之后，形如 f 1 2 3#c
+    return p == end || is_blank(*p) || *p == '\n' || *p == '#' ? p : nullptr;
+}
+
+// 未指定法向量的角
+constexpr GLuint NO_NORMAL = numeric_limits<GLuint>::max();
+
+// 一段文本的解析结果
+struct ObjChunk {
+    Mesh<> mesh;
+    // 与 indices 一一对应的法向量索引
+    std::vector<GLuint> normal_indices;
+    // 由负数索引得到的位置，其值只相对于本段开头，拼接时还需加上之前各段的顶点数或法向量数
+    std::vector<size_t> relative_slots;
+    std::vector<size_t> relative_normal_slots;
+};
+
+// 面片中一个角解析后的索引，relative 表示由负数索引得到
+struct ObjRef {
+    GLuint v, vn;
+    bool v_relative, vn_relative;
+};
+
+// 每解析这么多字节更新一次加载进度
+constexpr size_t PROGRESS_STEP = 1 << 20;
+
+// 解析 [begin, end) 范围内的所有行，出错时返回出错行的起始位置，否则返回 nullptr
+static const char *parse_obj(const char *begin, const char *end, ObjChunk &chunk, LoadProgress *progress) {
+    auto &vertices = chunk.mesh.vertices;
+    auto &faces    = chunk.mesh.indices;
+    auto &normals  = chunk.mesh.normals;
+
+    auto push_ref = [&](const ObjRef &ref) {
+        if (ref.v_relative) {
+            chunk.relative_slots.push_back(faces.size());
+        }
+        if (ref.vn_relative) {
+            chunk.relative_normal_slots.push_back(faces.size());
+        }
+        faces.push_back(ref.v);
+        chunk.normal_indices.push_back(ref.vn);
+    };
+
+    const char *reported_line     = begin;
+    size_t reported_vertex_floats = 0;
+
+    auto report_progress = [&](const char *line) {
+        progress->parsed_bytes += line - reported_line;
+        progress->vertices += (vertices.size() - reported_vertex_floats) / 3;
+        reported_line          = line;
+        reported_vertex_floats = vertices.size();
+    };
+
+    ObjCorner corner;
+    for (const char *line = begin; line < end; line = next_line(line, end)) {
+        if (progress && size_t(line - reported_line) >= PROGRESS_STEP) {
+            report_progress(line);
+        }
+        const char *p = skip_blank(line, end);
+        if (end - p < 2) {
+            continue;
+        }
+        if (p[0] == 'v' && is_blank(p[1])) {
+            if (!parse_vec3(p + 1, end, vertices)) {
+                return line;
+            }
+        } else if (p[0] == 'v' && p[1] == 'n' && end - p > 2 && is_blank(p[2])) {
+            if (!parse_vec3(p + 2, end, normals)) {
+                return line;
+            }
+        } else if (p[0] == 'f' && is_blank(p[1])) {
+            // 多边形以第一个角为中心扇形三角化
+            int64_t vertex_count = vertices.size() / 3;
+            int64_t normal_count = normals.size() / 3;
+            ObjRef first{}, prev{};
+            size_t n = 0;
+            for (p = skip_blank(p + 1, end); p < end && *p != '\n' && *p != '#'; p = skip_blank(p, end), ++n) {
+                if (!(p = parse_corner(p, end, corner))) {
+                    return line;
+                }
+                ObjRef ref;
+                ref.v_relative  = corner.v < 0;
+                ref.v           = ref.v_relative ? vertex_count + corner.v : corner.v - 1;
+                ref.vn_relative = corner.vn < 0;
+                ref.vn          = corner.vn == 0     ? NO_NORMAL
+                                  : ref.vn_relative ? normal_count + corner.vn
+                                                    : corner.vn - 1;
+                if (n == 0) {
+                    first = ref;
+                } else if (n >= 2) {
+                    push_ref(first);
+                    push_ref(prev);
+                    push_ref(ref);
+                }
+                prev = ref;
+            }
+            if (n < 3) {
+                return line;
+            }
+        }
+        // 注释及 vt、o、g、s、usemtl 等其余记录直接跳过
+    }
+    if (progress) {
+        report_progress(end);
+    }
+    return nullptr;
+}
+
+// 预扫描得到的各类记录数
+struct ObjCounts {
+    size_t vertices = 0, normals = 0, triangles = 0;
+};
+
+// 只统计记录数而不解析数值，多边形按扇形三角化后的三角形数计
+static ObjCounts count_obj_records(const char *begin, const char *end) {
+    ObjCounts counts;
+    for (const char *line = begin; line < end; line = next_line(line, end)) {
+        const char *p = skip_blank(line, end);
+        if (end - p < 2) {
+            continue;
+        }
+        if (p[0] == 'v' && is_blank(p[1])) {
+            ++counts.vertices;
+        } else if (p[0] == 'v' && p[1] == 'n' && end - p > 2 && is_blank(p[2])) {
+            ++counts.normals;
+        } else if (p[0] == 'f' && is_blank(p[1])) {
+            size_t n = 0;
+            for (p = skip_blank(p + 1, end); p < end && *p != '\n' && *p != '#'; p = skip_blank(p, end), ++n) {
+                while (p < end && !is_blank(*p) && *p != '\n' && *p != '#') {
+                    ++p;
+                }
+            }
+            if (n >= 3) {
+                counts.triangles += n - 2;
+            }
+        }
+    }
+    return counts;
+}
+
+// 并行解析时每块的最小字节数，更小的文件直接串行解析
+constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+// 每个线程分得的块数，多分几块以平衡各线程负载
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+// 把已解析完的块按文件顺序发布到 MeshStream 中
+class ObjPublisher {
+public:
+    ObjPublisher(MeshStream *stream, size_t chunks) : stream(stream), finished(chunks, nullptr) {
+    }
+
+    // 第 i 块解析完成，发布从 next 开始所有已完成的连续块；由各解析线程调用
+    void finish(size_t i, ObjChunk &chunk, const char *error) {
+        if (!stream) {
+            return;
+        }
+        std::lock_guard lock(mutex);
+        finished[i] = &chunk;
+        errors      = errors || error;
+        for (; next < finished.size() && finished[next] && !stopped; ++next) {
+            publish(*finished[next]);
+        }
+    }
+
+private:
+    // 各面片角的法向量引用方式：尚未确定、都没有法向量、都与顶点索引相同
+    enum { NORMALS_UNKNOWN, NORMALS_NONE, NORMALS_SAME };
+
+    MeshStream *stream;
+    std::mutex mutex;
+    vector<ObjChunk *> finished;
+    size_t next          = 0;
+    size_t vertex_offset = 0;
+    size_t normal_offset = 0;
+    size_t index_offset  = 0;
+    int normal_mode      = NORMALS_UNKNOWN;
+    bool errors          = false;
+    bool stopped         = false;
+
+    void stop() {
+        stopped = true;
+        stream->abort();
+    }
+
+    void publish(const ObjChunk &chunk) {
+        if (errors) {
+            return stop();
+        }
+        MeshPiece piece{vertex_offset, normal_offset, index_offset, 0, chunk.mesh};
+        auto &indices = piece.data.indices;
+        for (size_t slot : chunk.relative_slots) {
+            indices[slot] += vertex_offset / 3;
+        }
+        vector<GLuint> normal_indices = chunk.normal_indices;
+        for (size_t slot : chunk.relative_normal_slots) {
+            normal_indices[slot] += normal_offset / 3;
+        }
+        // 只有不需要合并顶点时，分段数据才与最终结果一致
+        for (size_t k = 0; k < indices.size(); ++k) {
+            int mode = normal_indices[k] == NO_NORMAL ? NORMALS_NONE
+                       : normal_indices[k] == indices[k] ? NORMALS_SAME
+                                                         : NORMALS_UNKNOWN;
+            if (mode == NORMALS_UNKNOWN || (normal_mode != NORMALS_UNKNOWN && mode != normal_mode)) {
+                return stop();
+            }
+            normal_mode = mode;
+        }
+        if (!indices.empty()) {
+            piece.max_index = *max_element(indices.begin(), indices.end());
+        }
+        vertex_offset += piece.data.vertices.size();
+        normal_offset += piece.data.normals.size();
+        index_offset += indices.size();
+        stream->publish(std::move(piece));
+    }
+};
+
+// 将文件切分为若干块并行解析，块边界对齐到行首
+// 各块结果按前缀和得到的偏移拼接，与串行解析的结果逐位相同
+// arena 不为空时先预扫描各块的记录数，result 的三个数组在 arena 中按精确大小一次分配，各块也按精确大小预留
+static const char *parse_obj_parallel(const char *begin, const char *end, ThreadPool *pool, ObjChunk &result,
+                                      LoadProgress *progress, MeshStream *stream, MeshArena *arena) {
+    size_t size   = end - begin;
+    size_t chunks = pool ? max<size_t>(1, min<size_t>(pool->size() * CHUNKS_PER_THREAD, size / MIN_CHUNK_SIZE)) : 1;
+
+    vector<const char *> bounds(chunks + 1);
+    bounds[0]      = begin;
+    bounds[chunks] = end;
+    for (size_t i = 1; i < chunks; ++i) {
+        const char *p = max(begin + size / chunks * i, bounds[i - 1]);
+        bounds[i]     = p == begin ? p : next_line(p - 1, end);
+    }
+
+    vector<ObjCounts> counts;
+    ObjCounts total;
+    if (arena || (stream && chunks > 1)) {
+        counts.resize(chunks);
+        auto count = [&](size_t i) { counts[i] = count_obj_records(bounds[i], bounds[i + 1]); };
+        if (pool) {
+            pool->parallel_for(chunks, count);
+        } else {
+            count(0);
+        }
+        for (const auto &c : counts) {
+            total.vertices += c.vertices;
+            total.normals += c.normals;
+            total.triangles += c.triangles;
+        }
+    }
+    if (arena) {
+        // 文件中没有法向量时加载后会为每个顶点生成一个，一并预留
+        size_t normals = total.normals ? total.normals : total.vertices;
+        arena->reserve(total.vertices * 3, normals * 3, total.triangles * 3);
+        result.mesh.vertices.reserve(total.vertices * 3);
+        result.mesh.normals.reserve(total.normals * 3);
+        result.mesh.indices.reserve(total.triangles * 3);
+        result.normal_indices.reserve(total.triangles * 3);
+    }
+
+    if (chunks <= 1) {
+        return parse_obj(begin, end, result, progress);
+    }
+
+    // 分段发布前先给出最终大小，供渲染线程预先分配缓冲区
+    if (stream) {
+        // 文件中没有法向量时，完整模型的法向量要等加载完成后才能生成，分段数据无法正确着色
+        if (total.normals == 0) {
+            stream->abort();
+        } else {
+            stream->reserve(total.vertices * 3, total.normals * 3, total.triangles * 3);
+        }
+    }
+
+    struct Chunk {
+        ObjChunk data;
+        const char *error = nullptr;
+    };
+    vector<Chunk> parts(chunks);
+    ObjPublisher publisher(stream, chunks);
+    pool->parallel_for(chunks, [&](size_t i) {
+        if (!counts.empty()) {
+            auto &part = parts[i].data;
+            part.mesh.vertices.reserve(counts[i].vertices * 3);
+            part.mesh.normals.reserve(counts[i].normals * 3);
+            part.mesh.indices.reserve(counts[i].triangles * 3);
+            part.normal_indices.reserve(counts[i].triangles * 3);
+        }
+        parts[i].error = parse_obj(bounds[i], bounds[i + 1], parts[i].data, progress);
+        publisher.finish(i, parts[i].data, parts[i].error);
+    });
+
+    for (auto &part : parts) {
+        if (part.error) {
+            return part.error;
+        }
+    }
+
+    // 各块数据在最终数组中的起始位置
+    vector<size_t> vertex_offset(chunks + 1), normal_offset(chunks + 1), index_offset(chunks + 1);
+    for (size_t i = 0; i < chunks; ++i) {
+        vertex_offset[i + 1] = vertex_offset[i] + parts[i].data.mesh.vertices.size();
+        normal_offset[i + 1] = normal_offset[i] + parts[i].data.mesh.normals.size();
+        index_offset[i + 1]  = index_offset[i] + parts[i].data.mesh.indices.size();
+    }
+    auto &mesh = result.mesh;
+    mesh.vertices.resize(vertex_offset[chunks]);
+    mesh.normals.resize(normal_offset[chunks]);
+    mesh.indices.resize(index_offset[chunks]);
+    result.normal_indices.resize(index_offset[chunks]);
+
+    pool->parallel_for(chunks, [&](size_t i) {
+        auto &part = parts[i].data;
+        copy(part.mesh.vertices.begin(), part.mesh.vertices.end(), mesh.vertices.begin() + vertex_offset[i]);
+        copy(part.mesh.normals.begin(), part.mesh.normals.end(), mesh.normals.begin() + normal_offset[i]);
+        copy(part.mesh.indices.begin(), part.mesh.indices.end(), mesh.indices.begin() + index_offset[i]);
+        copy(part.normal_indices.begin(), part.normal_indices.end(), result.normal_indices.begin() + index_offset[i]);
+        // 相对索引加上之前各块的顶点数或法向量数，越界的结果在之后统一检查
+        GLuint vertex_base = vertex_offset[i] / 3;
+        GLuint normal_base = normal_offset[i] / 3;
+        for (size_t slot : part.relative_slots) {
+            mesh.indices[index_offset[i] + slot] += vertex_base;
+        }
+        for (size_t slot : part.relative_normal_slots) {
+            result.normal_indices[index_offset[i] + slot] += normal_base;
+        }
+        part = ObjChunk();
+    });
+
+    return nullptr;
+}
+
+Mesh<> load_bunny_data(std::string_view obj_filename, unsigned threads, LoadProgress *progress, MeshStream *stream,
+                       MeshArena *arena) {
+    MappedFile file(obj_filename);
+    if (!file.is_open()) {
+        cerr << "Open `" << obj_filename << "` failed" << endl;
+        exit(1);
+    }
+    if (progress) {
+        progress->total_bytes = file.size();
+    }
+
+    // 返回值由移动构造得到，会沿用这里的内存资源
+    ObjChunk obj{make_mesh(arena ? arena : std::pmr::get_default_resource()), {}, {}, {}};
+    const char *begin = file.data();
+    const char *end   = begin + file.size();
+    const char *bad   = nullptr;
+    if (threads == 1) {
+        bad = parse_obj_parallel(begin, end, nullptr, obj, progress, stream, arena);
+    } else if (threads == 0) {
+        bad = parse_obj_parallel(begin, end, &ThreadPool::global(), obj, progress, stream, arena);
+    } else {
+        ThreadPool pool(threads);
+        bad = parse_obj_parallel(begin, end, &pool, obj, progress, stream, arena);
+    }
+    if (bad) {
+        auto lineno = count(begin, bad, '\n') + 1;
+        cerr << obj_filename << ":" << lineno << ": malformed record" << endl;
+        exit(1);
+    }
+
+    auto &mesh          = obj.mesh;
+    GLuint vertex_count = mesh.vertices.size() / 3;
+    GLuint normal_count = mesh.normals.size() / 3;
+    if (!all_of(mesh.indices.begin(), mesh.indices.end(), [&](GLuint v) { return v < vertex_count; })) {
+        cerr << obj_filename << ": face refers to an undefined vertex" << endl;
+        exit(1);
+    }
+    if (!all_of(obj.normal_indices.begin(), obj.normal_indices.end(),
+                [&](GLuint vn) { return vn == NO_NORMAL || vn < normal_count; })) {
+        cerr << obj_filename << ": face refers to an undefined normal" << endl;
+        exit(1);
+    }
+
+    // 面片未引用法向量时沿用 vn 与 v 按顺序对应的约定；
+    // 每个角的法向量索引都与顶点索引相同时数据已可直接使用，否则需要合并为新的顶点
+    bool no_normal_refs = all_of(obj.normal_indices.begin(), obj.normal_indices.end(),
+                                 [](GLuint vn) { return vn == NO_NORMAL; });
+    bool same_indices   = normal_count == vertex_count &&
+                        equal(mesh.indices.begin(), mesh.indices.end(), obj.normal_indices.begin());
+    if (!no_normal_refs && !same_indices) {
+        weld_vertex_normals(mesh, obj.normal_indices);
+        // 混用 v 与 v//vn 形式的角时，没有法向量的角合并后法向量为零，由所在的三角形补算
+        if (any_of(obj.normal_indices.begin(), obj.normal_indices.end(), [](GLuint vn) { return vn == NO_NORMAL; })) {
+            fill_missing_normals(mesh, threads == 1 ? nullptr : &ThreadPool::global());
+        }
+        if (stream) {
+            stream->abort();
+        }
+    }
+
+    return std::move(mesh);
+}
+
+}; // namespace glss
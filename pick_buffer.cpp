@@ -0,0 +1,87 @@
+#include <GL/glew.h>
+
+#include "pick_buffer.h"
+
+#include "gl_call_counter.h"
+
+#include <limits>
+
+namespace glss {
+
+void PickBuffer::begin(GLsizei side) {
+    if (!framebuffer) {
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &color);
+        glGenRenderbuffers(1, &depth);
+        glGenBuffers(1, &pbo);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (side != size) {
+        size = side;
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RG32UI, size, size);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, std::size_t(size) * size * 2 * sizeof(GLuint), nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // 整数颜色缓冲区不能用 glClearColor 清空
+    const GLuint no_id[4]   = {0, 0, 0, 0};
+    const GLfloat far_depth = 1.0f;
+    counted_gl(glViewport, 0, 0, size, size);
+    glClearBufferuiv(GL_COLOR, 0, no_id);
+    glClearBufferfv(GL_DEPTH, 0, &far_depth);
+    counted_gl(glEnable, GL_DEPTH_TEST);
+}
+
+void PickBuffer::end(const GLint viewport[4]) {
+    counted_gl(glReadBuffer, GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    counted_gl(glReadPixels, 0, 0, size, size, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    reading = true;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    counted_gl(glViewport, viewport[0], viewport[1], viewport[2], viewport[3]);
+    counted_gl(glDisable, GL_DEPTH_TEST);
+}
+
+bool PickBuffer::resolve(GLuint &id) {
+    reading = false;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    auto pixels = static_cast<const GLuint *>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    bool hit    = false;
+    if (pixels) {
+        // 与选择模式相同，取深度最小的图元；深度相同时取先遇到的像素
+        GLuint min_depth = std::numeric_limits<GLuint>::max();
+        for (std::size_t p = 0; p < std::size_t(size) * size; ++p) {
+            GLuint name = pixels[p * 2], z = pixels[p * 2 + 1];
+            if (name != 0 && (!hit || z < min_depth)) {
+                min_depth = z;
+                id        = name - 1;
+                hit       = true;
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return hit;
+}
+
+void PickBuffer::release() {
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteBuffers(1, &pbo);
+    framebuffer = color = depth = pbo = 0;
+    size                              = 0;
+    reading                           = false;
+}
+
+}; // namespace glss
@@ -0,0 +1,46 @@
+#ifndef PICK_BUFFER_H__
+#define PICK_BUFFER_H__
+
+#include <cstddef>
+
+inline namespace glss {
+
+// 拾取用的整数帧缓冲：只覆盖拾取矩形，每个像素记录最近图元的编号及其深度，
+// 结果经像素缓冲区对象（PBO）异步读回，下一帧再取出
+// 片元着色器输出 uvec2(图元编号 + 1, 深度 × (2^24 - 1))，未被覆盖的像素为 0
+// 需要 OpenGL 3.0（整数颜色缓冲区、glClearBuffer）；需要在 OpenGL 上下文有效时调用各函数
+class PickBuffer {
+public:
+    PickBuffer() = default;
+
+    PickBuffer(const PickBuffer &)            = delete;
+    PickBuffer &operator=(const PickBuffer &) = delete;
+
+    // 绑定 side × side 像素的帧缓冲并清空，开启深度测试；尺寸变化时重新分配存储
+    void begin(GLsizei side);
+
+    // 把帧缓冲的内容读入 PBO，恢复默认帧缓冲及 viewport，关闭深度测试
+    void end(const GLint viewport[4]);
+
+    // 是否有已读回、尚未取出的结果
+    bool pending() const {
+        return reading;
+    }
+
+    // 取出读回的结果：深度最小的像素上的图元编号，没有图元覆盖拾取矩形时返回 false
+    bool resolve(GLuint &id);
+
+    void release();
+
+private:
+    GLuint framebuffer = 0;
+    GLuint color       = 0; // GL_RG32UI 渲染缓冲区
+    GLuint depth       = 0;
+    GLuint pbo         = 0;
+    GLsizei size       = 0; // 当前存储的边长
+    bool reading       = false;
+};
+
+} // namespace glss
+
+#endif
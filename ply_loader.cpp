@@ -0,0 +1,500 @@
+#include <GL/glew.h>
+
+#include "mapped_file.h"
+#include "mesh_loader.h"
+#include "text_scan.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace glss {
+
+enum class PlyFormat { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+
+enum class PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, INVALID };
+
+struct PlyProperty {
+    string name;
+    PlyType type;
+    PlyType count_type; // 仅 list 属性使用
+    bool is_list;
+};
+
+struct PlyElement {
+    string name;
+    size_t count;
+    vector<PlyProperty> properties;
+};
+
+struct PlyHeader {
+    PlyFormat format;
+    vector<PlyElement> elements;
+    const char *body; // end_header 之后数据开始的位置
+};
+
+static PlyType ply_type(string_view name) {
+    if (name == "char" || name == "int8")
+        return PlyType::INT8;
+    if (name == "uchar" || name == "uint8")
+        return PlyType::UINT8;
+    if (name == "short" || name == "int16")
+        return PlyType::INT16;
+    if (name == "ushort" || name == "uint16")
+        return PlyType::UINT16;
+    if (name == "int" || name == "int32")
+        return PlyType::INT32;
+    if (name == "uint" || name == "uint32")
+        return PlyType::UINT32;
+    if (name == "float" || name == "float32")
+        return PlyType::FLOAT32;
+    if (name == "double" || name == "float64")
+        return PlyType::FLOAT64;
+    return PlyType::INVALID;
+}
+
+static size_t ply_type_size(PlyType type) {
+    switch (type) {
+    case PlyType::INT8:
+    case PlyType::UINT8:
+        return 1;
+    case PlyType::INT16:
+    case PlyType::UINT16:
+        return 2;
+    case PlyType::INT32:
+    case PlyType::UINT32:
+    case PlyType::FLOAT32:
+        return 4;
+    case PlyType::FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static bool host_is_little_endian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// 把一行按空白切分为单词
+static vector<string_view> split_words(const char *p, const char *end) {
+    vector<string_view> words;
+    for (p = skip_blank(p, end); p < end && *p != '\n'; p = skip_blank(p, end)) {
+        const char *w = p;
+        while (p < end && !is_blank(*p) && *p != '\n') {
+            ++p;
+        }
+        words.emplace_back(w, p - w);
+    }
+    return words;
+}
+
+// 解析文件头，出错时返回出错行的起始位置，否则返回 nullptr
+static const char *parse_ply_header(const char *begin, const char *end, PlyHeader &header) {
+    const char *line = begin;
+    auto words       = split_words(line, end);
+    if (words.size() != 1 || words[0] != "ply") {
+        return line;
+    }
+
+    bool has_format = false;
+    for (line = next_line(line, end); line < end; line = next_line(line, end)) {
+        words = split_words(line, end);
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info") {
+            continue;
+        }
+        if (words[0] == "end_header") {
+            header.body = next_line(line, end);
+            return has_format ? nullptr : line;
+        }
+        if (words[0] == "format" && words.size() == 3) {
+            if (words[1] == "ascii") {
+                header.format = PlyFormat::ASCII;
+            } else if (words[1] == "binary_little_endian") {
+                header.format = PlyFormat::BINARY_LITTLE_ENDIAN;
+            } else if (words[1] == "binary_big_endian") {
+                header.format = PlyFormat::BINARY_BIG_ENDIAN;
+            } else {
+                return line;
+            }
+            has_format = true;
+        } else if (words[0] == "element" && words.size() == 3) {
+            size_t count;
+            auto [ptr, ec] = from_chars(words[2].data(), words[2].data() + words[2].size(), count);
+            if (ec != errc()) {
+                return line;
+            }
+            header.elements.push_back({string(words[1]), count, {}});
+        } else if (words[0] == "property" && !header.elements.empty()) {
+            PlyProperty property;
+            if (words.size() == 5 && words[1] == "list") {
+                property = {string(words[4]), ply_type(words[3]), ply_type(words[2]), true};
+                if (property.count_type == PlyType::INVALID) {
+                    return line;
+                }
+            } else if (words.size() == 3) {
+                property = {string(words[2]), ply_type(words[1]), PlyType::INVALID, false};
+            } else {
+                return line;
+            }
+            if (property.type == PlyType::INVALID) {
+                return line;
+            }
+            header.elements.back().properties.push_back(std::move(property));
+        } else {
+            return line;
+        }
+    }
+    return line;
+}
+
+// 按文件格式逐个读取数值，越界或格式错误时置 failed
+class PlyReader {
+public:
+    PlyReader(const char *p, const char *end, PlyFormat format)
+        : pos(p), end(end), format(format),
+          swap(format != PlyFormat::ASCII && (format == PlyFormat::BINARY_LITTLE_ENDIAN) != host_is_little_endian()) {
+    }
+
+    double scalar(PlyType type) {
+        if (format == PlyFormat::ASCII) {
+            // ASCII 格式中各数值以空白或换行分隔
+            while (pos < end && (is_blank(*pos) || *pos == '\n')) {
+                ++pos;
+            }
+            double value = 0;
+            if (!(pos = parse_number(pos, end, value))) {
+                pos    = end;
+                failed = true;
+            }
+            return value;
+        }
+
+        size_t size = ply_type_size(type);
+        if (size_t(end - pos) < size) {
+            failed = true;
+            return 0;
+        }
+        unsigned char bytes[8];
+        memcpy(bytes, pos, size);
+        if (swap) {
+            reverse(bytes, bytes + size);
+        }
+        pos += size;
+        switch (type) {
+        case PlyType::INT8:
+            return load<int8_t>(bytes);
+        case PlyType::UINT8:
+            return load<uint8_t>(bytes);
+        case PlyType::INT16:
+            return load<int16_t>(bytes);
+        case PlyType::UINT16:
+            return load<uint16_t>(bytes);
+        case PlyType::INT32:
+            return load<int32_t>(bytes);
+        case PlyType::UINT32:
+            return load<uint32_t>(bytes);
+        case PlyType::FLOAT32:
+            return load<float>(bytes);
+        case PlyType::FLOAT64:
+            return load<double>(bytes);
+        default:
+            failed = true;
+            return 0;
+        }
+    }
+
+    // 列表的元素个数，为负数时读取失败
+    size_t list_count(const PlyProperty &property) {
+        double n = scalar(property.count_type);
+        if (n < 0) {
+            failed = true;
+            return 0;
+        }
+        return n;
+    }
+
+    void skip(const PlyProperty &property) {
+        if (property.is_list) {
+            size_t n = list_count(property);
+            for (size_t i = 0; i < n && !failed; ++i) {
+                scalar(property.type);
+            }
+        } else {
+            scalar(property.type);
+        }
+    }
+
+    const char *pos;
+    const char *end;
+    const PlyFormat format;
+    const bool swap; // 文件字节序与本机不同
+    bool failed = false;
+
+private:
+    template <typename T>
+    static T load(const unsigned char *bytes) {
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+};
+
+// 元素中所有属性均为定长标量时每项的字节数，否则为 0
+static size_t fixed_stride(const PlyElement &element) {
+    size_t stride = 0;
+    for (const auto &property : element.properties) {
+        if (property.is_list) {
+            return 0;
+        }
+        stride += ply_type_size(property.type);
+    }
+    return stride;
+}
+
+static bool is_index_list(const PlyProperty &property) {
+    return property.is_list && (property.name == "vertex_indices" || property.name == "vertex_index");
+}
+
+// 元素每项至少占用的字节数：ASCII 格式中每个数值至少占一个字符和一个分隔符；
+// 列表至少包含计数，面片的顶点索引列表至少包含三个索引
+static size_t min_record_size(PlyFormat format, const PlyElement &element) {
+    size_t size = 0;
+    for (const auto &property : element.properties) {
+        size_t values = !property.is_list ? 1 : element.name == "face" && is_index_list(property) ? 3 : 0;
+        if (format == PlyFormat::ASCII) {
+            size += (values + property.is_list) * 2;
+        } else {
+            size += values * ply_type_size(property.type) + (property.is_list ? ply_type_size(property.count_type) : 0);
+        }
+    }
+    return size;
+}
+
+static void skip_element(PlyReader &reader, const PlyElement &element) {
+    size_t stride = reader.format == PlyFormat::ASCII ? 0 : fixed_stride(element);
+    if (stride) {
+        if (size_t(reader.end - reader.pos) / stride < element.count) {
+            reader.failed = true;
+        } else {
+            reader.pos += stride * element.count;
+        }
+        return;
+    }
+    for (size_t i = 0; i < element.count && !reader.failed; ++i) {
+        for (const auto &property : element.properties) {
+            reader.skip(property);
+        }
+    }
+}
+
+static void read_vertices(PlyReader &reader, const PlyElement &element, Mesh<> &mesh) {
+    // 各属性在 x y z nx ny nz 中的位置，-1 表示不需要
+    const char *names[] = {"x", "y", "z", "nx", "ny", "nz"};
+    vector<int> slots;
+    int found[6] = {-1, -1, -1, -1, -1, -1};
+    for (size_t k = 0; k < element.properties.size(); ++k) {
+        auto it = find(begin(names), end(names), element.properties[k].name);
+        int slot = it == end(names) ? -1 : it - begin(names);
+        slots.push_back(element.properties[k].is_list ? -1 : slot);
+        if (slots.back() >= 0) {
+            found[slot] = k;
+        }
+    }
+    if (found[0] < 0 || found[1] < 0 || found[2] < 0) {
+        reader.failed = true;
+        return;
+    }
+    bool has_normals = found[3] >= 0 && found[4] >= 0 && found[5] >= 0;
+
+    mesh.vertices.resize(element.count * 3);
+    if (has_normals) {
+        mesh.normals.resize(element.count * 3);
+    }
+
+    // 二进制且字节序与本机相同、坐标为 float 时直接按偏移拷贝
+    size_t stride = reader.format == PlyFormat::ASCII || reader.swap ? 0 : fixed_stride(element);
+    bool all_float = true;
+    for (int k : found) {
+        all_float = all_float && (k < 0 || element.properties[k].type == PlyType::FLOAT32);
+    }
+    if (stride && all_float) {
+        if (size_t(reader.end - reader.pos) / stride < element.count) {
+            reader.failed = true;
+            return;
+        }
+        size_t offsets[6];
+        for (int slot = 0; slot < 6; ++slot) {
+            size_t offset = 0;
+            for (int k = 0; k < found[slot]; ++k) {
+                offset += ply_type_size(element.properties[k].type);
+            }
+            offsets[slot] = offset;
+        }
+        const char *base = reader.pos;
+        if (stride == 3 * sizeof(float) && offsets[0] == 0 && offsets[1] == 4 && offsets[2] == 8) {
+            // 只有 x y z 三个属性，整块拷贝
+            memcpy(mesh.vertices.data(), base, element.count * stride);
+        } else {
+            for (size_t i = 0; i < element.count; ++i, base += stride) {
+                for (int slot = 0; slot < 3; ++slot) {
+                    memcpy(&mesh.vertices[i * 3 + slot], base + offsets[slot], sizeof(float));
+                }
+                for (int slot = 3; has_normals && slot < 6; ++slot) {
+                    memcpy(&mesh.normals[i * 3 + slot - 3], base + offsets[slot], sizeof(float));
+                }
+            }
+        }
+        reader.pos += element.count * stride;
+        return;
+    }
+
+    for (size_t i = 0; i < element.count && !reader.failed; ++i) {
+        for (size_t k = 0; k < element.properties.size(); ++k) {
+            const auto &property = element.properties[k];
+            int slot             = slots[k];
+            if (slot < 0) {
+                reader.skip(property);
+            } else if (slot < 3) {
+                mesh.vertices[i * 3 + slot] = reader.scalar(property.type);
+            } else {
+                double value = reader.scalar(property.type);
+                if (has_normals) {
+                    mesh.normals[i * 3 + slot - 3] = value;
+                }
+            }
+        }
+    }
+}
+
+static void read_faces(PlyReader &reader, const PlyElement &element, Mesh<> &mesh) {
+    auto list = find_if(element.properties.begin(), element.properties.end(), is_index_list);
+    if (list == element.properties.end()) {
+        reader.failed = true;
+        return;
+    }
+    auto &indices = mesh.indices;
+    indices.reserve(element.count * 3);
+
+    // 最常见的布局：只有一个 uchar 计数、int 索引的列表且全为三角形，每个面 13 字节
+    bool simple = reader.format != PlyFormat::ASCII && !reader.swap && element.properties.size() == 1 &&
+                  list->count_type == PlyType::UINT8 &&
+                  (list->type == PlyType::INT32 || list->type == PlyType::UINT32);
+    for (size_t i = 0; i < element.count && !reader.failed; ++i) {
+        if (simple && reader.end - reader.pos >= 13 && *reader.pos == 3) {
+            size_t n = indices.size();
+            indices.resize(n + 3);
+            memcpy(&indices[n], reader.pos + 1, 3 * sizeof(GLuint));
+            reader.pos += 13;
+            continue;
+        }
+        for (const auto &property : element.properties) {
+            if (&property != &*list) {
+                reader.skip(property);
+                continue;
+            }
+            // 多边形以第一个顶点为中心扇形三角化
+            size_t n     = reader.list_count(property);
+            GLuint first = 0, prev = 0;
+            if (n < 3) {
+                reader.failed = true;
+            }
+            for (size_t k = 0; k < n && !reader.failed; ++k) {
+                double value = reader.scalar(property.type);
+                if (value < 0) {
+                    reader.failed = true;
+                }
+                GLuint v = value;
+                if (k == 0) {
+                    first = v;
+                } else if (k >= 2) {
+                    indices.insert(indices.end(), {first, prev, v});
+                }
+                prev = v;
+            }
+        }
+    }
+}
+
+Mesh<> load_ply(std::string_view ply_filename, LoadProgress *progress, MeshArena *arena) {
+    MappedFile file(ply_filename);
+    if (!file.is_open()) {
+        cerr << "Open `" << ply_filename << "` failed" << endl;
+        exit(1);
+    }
+    if (progress) {
+        progress->total_bytes = file.size();
+    }
+
+    const char *begin = file.data();
+    const char *end   = begin + file.size();
+    PlyHeader header;
+    if (const char *bad = parse_ply_header(begin, end, header)) {
+        auto lineno = count(begin, bad, '\n') + 1;
+        cerr << ply_filename << ":" << lineno << ": malformed header" << endl;
+        exit(1);
+    }
+
+    // 各元素的个数不能超过剩余数据按每项最小字节数所能容纳的个数，否则截断或伪造的文件头会导致巨大的分配；
+    // ASCII 格式最后一个数值之后可以没有分隔符
+    size_t remaining = end - header.body + (header.format == PlyFormat::ASCII ? 1 : 0);
+    for (const auto &element : header.elements) {
+        size_t size = min_record_size(header.format, element);
+        if (size > 0 && element.count > remaining / size) {
+            cerr << ply_filename << ": malformed element `" << element.name << "`" << endl;
+            exit(1);
+        }
+        remaining -= element.count * size;
+    }
+
+    // 读入的顶点没有法向量时之后会生成，因此法向量总按顶点数预留
+    if (arena) {
+        size_t vertices = 0, faces = 0;
+        for (const auto &element : header.elements) {
+            if (element.name == "vertex") {
+                vertices = element.count;
+            } else if (element.name == "face") {
+                faces = element.count;
+            }
+        }
+        arena->reserve(vertices * 3, vertices * 3, faces * 3);
+    }
+
+    Mesh<> mesh = make_mesh(arena ? arena : std::pmr::get_default_resource());
+    PlyReader reader(header.body, end, header.format);
+    for (const auto &element : header.elements) {
+        if (element.name == "vertex") {
+            read_vertices(reader, element, mesh);
+        } else if (element.name == "face") {
+            read_faces(reader, element, mesh);
+        } else {
+            skip_element(reader, element);
+        }
+        if (reader.failed) {
+            cerr << ply_filename << ": malformed element `" << element.name << "`" << endl;
+            exit(1);
+        }
+        if (progress) {
+            progress->parsed_bytes = reader.pos - begin;
+            progress->vertices     = mesh.vertices.size() / 3;
+        }
+    }
+
+    GLuint vertex_count = mesh.vertices.size() / 3;
+    if (!all_of(mesh.indices.begin(), mesh.indices.end(), [&](GLuint v) { return v < vertex_count; })) {
+        cerr << ply_filename << ": face refers to an undefined vertex" << endl;
+        exit(1);
+    }
+
+    return mesh;
+}
+
+}; // namespace glss
@@ -0,0 +1,26 @@
+#version 120
+#if __VERSION__ < 140
+#extension GL_ARB_uniform_buffer_object : require
+#else
+// 以 #version 330 core 编译时把 GLSL 1.20 的关键字映射到新写法
+#define attribute in
+#define varying out
+#endif
+
+// 各程序共用的观察与投影矩阵
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 proj;
+};
+
+attribute vec3 position;
+attribute vec4 color;
+attribute vec4 center;  // 每个实例一个：xyz 为球心，w 为半径
+
+
+varying vec4 v_color;
+
+void main() {
+    v_color = color;
+    gl_Position =  proj * view * vec4(position * center.w + center.xyz, 1.0);
+}
@@ -1,8 +1,18 @@
 #version 120
+#if __VERSION__ < 140
+#extension GL_ARB_uniform_buffer_object : require
+#else
+// 以 #version 330 core 编译时把 GLSL 1.20 的写法映射到新写法
+#define varying in
+#define texture2D texture
+#define gl_FragColor frag_color
+out vec4 frag_color;
+#endif
+
+// MAX_LIGHTS 由程序按 uniform 块的大小上限定义
 
 varying vec3 v_normal;
 varying vec3 v_viewcoord;
-const int LIGHTS = 2;
 
 struct Material {
 	//vec4 emission;
@@ -16,57 +26,99 @@ struct LightSource {
 	vec4  ambient;
 	vec4  diffuse;
 	vec4  specular;
-	vec4  position;
+	vec4  position;  // w 为作用半径，不大于 0 时不衰减
 	// vec4  halfVector;
 	// vec3  spotDirection;
 	// float spotExponent;
 	// float spotCutoff;
 	// float spotCosCutoff;
-	// float constantAttenuation; // K0
-	// float linearAttenuation;   // K1
-	// float quadraticAttenuation;// K2
 };
 
-uniform Material material;
-uniform LightSource lights[LIGHTS];
-uniform vec4 global_ambient;
-uniform mat4 view;
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 proj;
+};
 
-void main()
+layout(std140) uniform Lights {
+	LightSource lights[MAX_LIGHTS];
+};
+
+// 材质与着色参数
+layout(std140) uniform Shading {
+	Material material;
+	vec4 global_ambient;
+	vec4 tile_params;   // 视口左下角的像素坐标、分块边长、tile_lights 的宽度
+	vec2 tile_counts;   // 横向与纵向的分块数
+	float tile_rows;    // tile_lights 的行数
+	int light_count;
+	int use_tiles;      // 非 0 时按分块遍历光源
+};
+
+// 分块光源剔除：tile_grid 的每个像素对应屏幕上的一个分块，
+// r 为该分块的光源编号在 tile_lights 中的起始位置，g 为个数
+uniform sampler2D tile_grid;
+uniform sampler2D tile_lights;
+
+vec4 ambient, diffuse, specular;
+
+// 累加第 i 个光源的贡献
+void shade(int i, vec3 N, vec3 V)
 {
-	// 归一化法向量
-	vec3 N = normalize(v_normal);
+	LightSource light = lights[i];
+	// position.w 存放作用半径，变换时固定取 w = 1：原先各光源的 w 都为 1，按点光源经观察矩阵（含平移）变换，与此相同
+	vec3 to_light = vec3(view * vec4(light.position.xyz, 1.0)) - v_viewcoord;
 
-	// 归一化的入射光线向量
-	vec3 light_in[LIGHTS];
-	for (int i = 0; i < LIGHTS; ++i) {
-		light_in[i] = normalize(v_viewcoord - vec3(view * lights[i].position));
+	// 有作用半径的光源在半径处平滑衰减为 0
+	float attenuation = 1.0;
+	if (light.position.w > 0.0) {
+		float x = min(length(to_light) / light.position.w, 1.0);
+		attenuation = (1.0 - x * x) * (1.0 - x * x);
 	}
 
-	vec4 ambient, diffuse, specular;
+	// 归一化的入射光线向量
+	vec3 light_in = -normalize(to_light);
 
 	// Ambient，环境光
-	ambient = global_ambient * material.ambient;
-	for (int i = 0; i < LIGHTS; ++i) {
-		ambient += lights[i].ambient * material.ambient;
-	}
+	ambient += attenuation * light.ambient * material.ambient;
 
 	// Diffuse，漫反射光，强度与入射角余弦成正比
-	diffuse = vec4(0.0);
-	for (int i = 0; i < LIGHTS; ++i) {
-		float ratio = max(dot(N, -light_in[i]), 0.0);
-		diffuse += material.diffuse * lights[i].diffuse * ratio;
-	}
-	diffuse.a = 1.0;
+	float ratio = max(dot(N, -light_in), 0.0);
+	diffuse += attenuation * material.diffuse * light.diffuse * ratio;
 
 	// Specular，镜面反射光，强度与反射光线与观察方向的夹角的余弦成正相关
-	specular = vec4(0.0);
+	vec3 R = reflect(light_in, N);  // 反射光线方向
+	float RdotV = max(dot(R, V), 0.0);
+	specular += attenuation * material.specular * light.specular * pow(RdotV, material.shininess);
+}
+
+void main()
+{
+	// 归一化法向量
+	vec3 N = normalize(v_normal);
 	vec3 V = normalize(-v_viewcoord);     // 观察方向
-	for (int i = 0; i < LIGHTS; ++i) {
-		vec3 R = reflect(light_in[i], N);  // 反射光线方向
-		float RdotV = max(dot(R, V), 0.0);
-		specular += material.specular * lights[i].specular * pow(RdotV, material.shininess);
+
+	ambient = global_ambient * material.ambient;
+	diffuse = vec4(0.0);
+	specular = vec4(0.0);
+
+	if (use_tiles != 0) {
+		// 只遍历影响本像素所在分块的光源
+		vec2 tile = floor((gl_FragCoord.xy - tile_params.xy) / tile_params.z);
+		vec4 cell = texture2D(tile_grid, (tile + 0.5) / tile_counts);
+		float first = cell.r;
+		int count = int(cell.g + 0.5);
+		for (int k = 0; k < count; ++k) {
+			float entry = first + float(k);
+			float row = floor(entry / tile_params.w);
+			vec2 uv = vec2(entry - row * tile_params.w + 0.5, row + 0.5) / vec2(tile_params.w, tile_rows);
+			shade(int(texture2D(tile_lights, uv).r + 0.5), N, V);
+		}
+	} else {
+		for (int i = 0; i < light_count; ++i) {
+			shade(i, N, V);
+		}
 	}
+	diffuse.a = 1.0;
 	specular.a = 1.0;
 
 	gl_FragColor = ambient + diffuse + specular;
@@ -1,11 +1,22 @@
 #version 120
+#if __VERSION__ < 140
+#extension GL_ARB_uniform_buffer_object : require
+#else
+// 以 #version 330 core 编译时把 GLSL 1.20 的关键字映射到新写法
+#define attribute in
+#define varying out
+#endif
+
+// 各程序共用的观察与投影矩阵
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 proj;
+};
 
 attribute vec3 position;
 attribute vec3 normal;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
 
 varying vec3 v_normal;           // 法向量
 varying vec3 v_viewcoord;       // 在观察坐标系下的顶点坐标
@@ -0,0 +1,17 @@
+#version 120
+#if __VERSION__ < 150
+// gl_PrimitiveID 与无符号整数输出
+#extension GL_EXT_gpu_shader4 : require
+varying out uvec2 pick_id;
+#else
+out uvec2 pick_id;
+#endif
+
+// 本次绘制第一个图元的编号，gl_PrimitiveID 在每次绘制时从 0 开始
+uniform int id_base;
+
+void main()
+{
+	// 编号加一，0 表示没有图元；深度转为整数后可直接比较
+	pick_id = uvec2(uint(id_base + gl_PrimitiveID) + 1u, uint(gl_FragCoord.z * 16777215.0));
+}
@@ -0,0 +1,15 @@
+#version 120
+#if __VERSION__ >= 140
+// 以 #version 330 core 编译时把 GLSL 1.20 的关键字映射到新写法
+#define attribute in
+#endif
+
+// 拾取矩阵、投影、观察与模型矩阵之积
+uniform mat4 mvp;
+
+attribute vec3 position;
+
+void main()
+{
+	gl_Position = mvp * vec4(position, 1.0);
+}
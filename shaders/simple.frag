@@ -1,4 +1,10 @@
 #version 120
+#if __VERSION__ >= 140
+// 以 #version 330 core 编译时把 GLSL 1.20 的写法映射到新写法
+#define varying in
+#define gl_FragColor frag_color
+out vec4 frag_color;
+#endif
 
 varying vec4 v_color;
 
@@ -0,0 +1,97 @@
+#include <GL/glew.h>
+
+#include "mapped_file.h"
+#include "mesh_loader.h"
+#include "mesh_ops.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+using namespace std;
+
+namespace glss {
+
+// 二进制 STL：80 字节文件头、uint32 三角形个数，之后每个三角形 50 字节：
+// 面法向量 3 个 float、三个顶点各 3 个 float、2 字节属性，均为小端序
+constexpr size_t STL_HEADER_SIZE   = 80 + sizeof(uint32_t);
+constexpr size_t STL_TRIANGLE_SIZE = 50;
+
+// 解码时每块至少处理的三角形个数
+constexpr size_t MIN_STL_BLOCK = 1 << 15;
+
+static bool host_is_little_endian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+static uint32_t read_uint32_le(const char *p) {
+    auto b = reinterpret_cast<const unsigned char *>(p);
+    return uint32_t(b[0]) | uint32_t(b[1]) << 8 | uint32_t(b[2]) << 16 | uint32_t(b[3]) << 24;
+}
+
+Mesh<> load_stl(std::string_view stl_filename, float weld_epsilon, unsigned threads, LoadProgress *progress) {
+    MappedFile file(stl_filename);
+    if (!file.is_open()) {
+        cerr << "Open `" << stl_filename << "` failed" << endl;
+        exit(1);
+    }
+    if (progress) {
+        progress->total_bytes = file.size();
+    }
+
+    const char *begin = file.data();
+    size_t triangles  = file.size() >= STL_HEADER_SIZE ? read_uint32_le(begin + 80) : 0;
+    if (file.size() < STL_HEADER_SIZE || (file.size() - STL_HEADER_SIZE) / STL_TRIANGLE_SIZE < triangles) {
+        // ASCII STL 以 "solid" 开头，其长度通常与按二进制解释得到的三角形个数不符
+        if (file.size() >= 5 && memcmp(begin, "solid", 5) == 0) {
+            cerr << stl_filename << ": ASCII STL is not supported" << endl;
+        } else {
+            cerr << stl_filename << ": truncated binary STL" << endl;
+        }
+        exit(1);
+    }
+
+    ThreadPool *pool = threads == 1 ? nullptr : &ThreadPool::global();
+
+    // 先按三角形展开为每个角一个顶点，忽略文件中的面法向量（很多导出程序写入的是零向量）
+    Mesh<> mesh;
+    mesh.vertices.resize(triangles * 9);
+    mesh.indices.resize(triangles * 3);
+    bool swap_bytes = !host_is_little_endian();
+    parallel_blocks(pool, triangles, block_count(pool, triangles, MIN_STL_BLOCK), [&](size_t, size_t first, size_t last) {
+        const char *p = begin + STL_HEADER_SIZE + first * STL_TRIANGLE_SIZE;
+        for (size_t t = first; t < last; ++t, p += STL_TRIANGLE_SIZE) {
+            GLfloat *out = &mesh.vertices[t * 9];
+            memcpy(out, p + 3 * sizeof(float), 9 * sizeof(float));
+            if (swap_bytes) {
+                for (int k = 0; k < 9; ++k) {
+                    uint32_t bits;
+                    memcpy(&bits, out + k, sizeof(bits));
+                    bits = read_uint32_le(reinterpret_cast<const char *>(&bits));
+                    memcpy(out + k, &bits, sizeof(bits));
+                }
+            }
+        }
+        iota(mesh.indices.begin() + first * 3, mesh.indices.begin() + last * 3, GLuint(first * 3));
+        if (progress) {
+            progress->parsed_bytes += (last - first) * STL_TRIANGLE_SIZE;
+        }
+    });
+
+    weld_positions(mesh, weld_epsilon, pool);
+    generate_normals(mesh, pool);
+
+    if (progress) {
+        progress->parsed_bytes = file.size();
+        progress->vertices     = mesh.vertices.size() / 3;
+    }
+    return mesh;
+}
+
+}; // namespace glss
@@ -0,0 +1,45 @@
+#ifndef TEXT_SCAN_H__
+#define TEXT_SCAN_H__
+
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+// 文本模型文件解析共用的扫描函数，均作用于 [p, end) 范围，解析失败时返回 nullptr
+inline namespace glss {
+
+// 行内空白，'\r' 一并视为空白以兼容 CRLF 换行
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char *skip_blank(const char *p, const char *end) {
+    while (p < end && is_blank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline const char *next_line(const char *p, const char *end) {
+    auto nl = static_cast<const char *>(memchr(p, '\n', end - p));
+    return nl ? nl + 1 : end;
+}
+
+// 跳过行内空白后解析一个数，允许带正号
+template <typename T>
+inline const char *parse_number(const char *p, const char *end, T &value) {
+    p = skip_blank(p, end);
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    return ec == std::errc() ? ptr : nullptr;
+}
+
+inline const char *parse_float(const char *p, const char *end, float &value) {
+    return parse_number(p, end, value);
+}
+
+} // namespace glss
+
+#endif
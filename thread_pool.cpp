@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace glss {
+
+// 当前线程是否正在执行线程池任务，用于避免嵌套调用时死锁
+static thread_local bool in_pool_task = false;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_main, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t : workers) {
+        t.join();
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run_tasks() {
+    bool nested  = in_pool_task;
+    in_pool_task = true;
+    for (std::size_t i; (i = next_index.fetch_add(1, std::memory_order_relaxed)) < job_count;) {
+        (*job)(i);
+    }
+    in_pool_task = nested;
+}
+
+void ThreadPool::worker_main() {
+    std::size_t seen = 0;
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        lock.unlock();
+        run_tasks();
+        lock.lock();
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)> &task) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers.empty() || in_pool_task) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard submit_lock(submit_mutex);
+    {
+        std::lock_guard lock(mutex);
+        job       = &task;
+        job_count = count;
+        next_index.store(0, std::memory_order_relaxed);
+        pending = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    run_tasks();
+
+    // 每个工作线程都确认过本轮任务后才能返回，避免迟到的线程读到下一轮的状态
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return pending == 0; });
+    job = nullptr;
+}
+
+}; // namespace glss
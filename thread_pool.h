@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_H__
+#define THREAD_POOL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline namespace glss {
+
+// 固定数量工作线程的线程池，只提供阻塞式的 parallel_for
+class ThreadPool {
+public:
+    // threads 为参与计算的线程总数（含调用线程），0 表示使用全部硬件线程
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // 参与计算的线程总数
+    unsigned size() const {
+        return workers.size() + 1;
+    }
+
+    // 对 i ∈ [0, count) 调用 task(i)，调用线程也参与执行，全部完成后返回
+    // 在任务内部再次调用时退化为串行执行
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)> &task);
+
+    // 进程内共享的线程池
+    static ThreadPool &global();
+
+private:
+    void worker_main();
+    void run_tasks();
+
+    std::vector<std::thread> workers;
+
+    std::mutex submit_mutex; // 同一时刻只执行一个 parallel_for
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(std::size_t)> *job = nullptr;
+    std::size_t job_count                       = 0;
+    std::atomic<std::size_t> next_index         = 0;
+    std::size_t generation                      = 0;
+    std::size_t pending                         = 0; // 尚未完成本轮任务的工作线程数
+    bool stopping                               = false;
+};
+
+// 把 [0, count) 均分为 blocks 块，对第 b 块调用 task(b, begin, end)；pool 为空时在调用线程中串行执行
+template <typename Task>
+void parallel_blocks(ThreadPool *pool, std::size_t count, std::size_t blocks, const Task &task) {
+    auto run = [&](std::size_t b) { task(b, count * b / blocks, count * (b + 1) / blocks); };
+    if (pool) {
+        pool->parallel_for(blocks, run);
+    } else {
+        for (std::size_t b = 0; b < blocks; ++b) {
+            run(b);
+        }
+    }
+}
+
+// 处理 count 个元素时的分块数：每个线程若干块，每块至少 min_block 个元素
+inline std::size_t block_count(ThreadPool *pool, std::size_t count, std::size_t min_block) {
+    constexpr std::size_t BLOCKS_PER_THREAD = 4;
+    std::size_t blocks = pool ? pool->size() * BLOCKS_PER_THREAD : 1;
+    return std::max<std::size_t>(1, std::min(blocks, count / min_block));
+}
+
+} // namespace glss
+
+#endif
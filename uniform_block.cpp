@@ -0,0 +1,48 @@
+#include <GL/glew.h>
+
+#include "uniform_block.h"
+
+#include "gl_state.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace glss {
+
+void UniformBlock::create(GLuint binding_point, std::size_t size) {
+    binding  = binding_point;
+    capacity = size;
+    glGenBuffers(1, &buffer);
+    GlState::global().bind_buffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    // 同时绑定到通用绑定点，与 GlState 的记录一致
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+    uploaded.clear();
+}
+
+bool UniformBlock::update(const void *data, std::size_t size) {
+    size = std::min(size, capacity);
+    if (size == uploaded.size() && (size == 0 || std::memcmp(data, uploaded.data(), size) == 0)) {
+        return false;
+    }
+    GlState::global().bind_buffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    auto bytes = static_cast<const unsigned char *>(data);
+    uploaded.assign(bytes, bytes + size);
+    return true;
+}
+
+void UniformBlock::attach(GLuint program, const char *name) const {
+    GLuint index = glGetUniformBlockIndex(program, name);
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, index, binding);
+    }
+}
+
+void UniformBlock::release() {
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    uploaded.clear();
+}
+
+}; // namespace glss
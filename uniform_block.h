@@ -0,0 +1,43 @@
+#ifndef UNIFORM_BLOCK_H__
+#define UNIFORM_BLOCK_H__
+
+#include <cstddef>
+#include <vector>
+
+inline namespace glss {
+
+// 绑定到固定绑定点的 uniform 缓冲区，保留上次上传的内容，内容不变时不再上传
+// 需要在 OpenGL 上下文有效时调用 create 与 release
+class UniformBlock {
+public:
+    UniformBlock() = default;
+
+    UniformBlock(const UniformBlock &)            = delete;
+    UniformBlock &operator=(const UniformBlock &) = delete;
+
+    // 分配 capacity 字节的缓冲区并绑定到 binding
+    void create(GLuint binding, std::size_t capacity);
+
+    // data 的前 size 字节与上次上传的不同时更新缓冲区，返回是否上传；超出容量的部分被忽略
+    bool update(const void *data, std::size_t size);
+
+    // 下次 update 时无论内容是否变化都上传
+    void invalidate() {
+        uploaded.clear();
+    }
+
+    // 把 program 中名为 name 的 uniform 块连接到本缓冲区的绑定点，程序中没有该块时忽略
+    void attach(GLuint program, const char *name) const;
+
+    void release();
+
+private:
+    GLuint buffer        = 0;
+    GLuint binding       = 0;
+    std::size_t capacity = 0;
+    std::vector<unsigned char> uploaded; // 缓冲区中的内容
+};
+
+} // namespace glss
+
+#endif
@@ -6,73 +6,13 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <limits>
+#include <iterator>
 #include <string>
 
 using namespace std;
 
 namespace glss {
 
-static void eatline(std::istream &input) {
-    input.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-}
-
-Mesh<> load_bunny_data(std::string_view obj_filename) {
-    ifstream fin;
-    fin.open(filesystem::path(obj_filename));
-    if (!fin.is_open()) {
-        cerr << "Open `" << obj_filename << "` failed" << endl;
-        exit(1);
-    }
-
-    Mesh<> mesh;
-    auto &vertices = mesh.vertices;
-    auto &faces    = mesh.indices;
-    auto &normals  = mesh.normals;
-
-    // 开始读取文件
-    string token;
-    float x, y, z;
-    GLuint i1, i2, i3;
-    while (!fin.eof()) {
-        fin >> token;
-        if (token == "#") {
-            eatline(fin);
-        } else if (token == "v") {
-            fin >> x >> y >> z;
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            eatline(fin);
-        } else if (token == "vn") {
-            fin >> x >> y >> z;
-            normals.push_back(x);
-            normals.push_back(y);
-            normals.push_back(z);
-            eatline(fin);
-        } else if (token == "f") {
-            fin >> i1;
-            fin.get();
-            fin.get();
-            fin >> i1;
-            fin >> i2;
-            fin.get();
-            fin.get();
-            fin >> i2;
-            fin >> i3;
-            fin.get();
-            fin.get();
-            fin >> i3;
-            faces.push_back(i1 - 1);
-            faces.push_back(i2 - 1);
-            faces.push_back(i3 - 1);
-            eatline(fin);
-        }
-    }
-
-    return mesh;
-}
-
 template <typename T, typename A>
 static void push3(std::vector<T, A> &vertices, T x, T y, T z) {
     vertices.push_back(x);
@@ -154,21 +94,26 @@ Mesh<> genSolidSphere(GLfloat radius, GLint slices, GLint stacks) {
     return {vertices, indices, normals};
 }
 
-static GLuint load_shader(std::string_view shader_file, GLenum shader_type) {
+static GLuint load_shader(std::string_view shader_file, GLenum shader_type, std::string_view header,
+                          std::string_view version) {
     ifstream fin;
     fin.open(std::filesystem::path(shader_file));
-    GLint file_len;
-    GLchar *source;
-
-    fin.seekg(0, ios_base::end);
-    file_len = fin.tellg();
-    source   = new GLchar[file_len];
-    fin.seekg(0, ios_base::beg);
-    fin.read(source, file_len);
-
-    GLuint shader = glCreateShader(shader_type);
-    glShaderSource(shader, 1, &source, &file_len);
-    delete[] source;
+    string source((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+
+    // version 替换第一行的 #version，header 插在 #version 所在行之后
+    size_t line_end = source.find('\n');
+    line_end        = line_end == string::npos ? source.size() : line_end + 1;
+    if (!version.empty()) {
+        string line = string(version) + "\n";
+        source.replace(0, line_end, line);
+        line_end = line.size();
+    }
+    source.insert(line_end, header);
+
+    GLuint shader      = glCreateShader(shader_type);
+    const GLchar *text = source.data();
+    GLint file_len     = source.size();
+    glShaderSource(shader, 1, &text, &file_len);
     glCompileShader(shader);
 
     GLint compiled;
@@ -187,9 +132,10 @@ static GLuint load_shader(std::string_view shader_file, GLenum shader_type) {
     return shader;
 }
 
-GLuint load_program(std::string_view vertex_shader_file, std::string_view fragment_shader_file) {
-    GLuint vertex_shader   = load_shader(vertex_shader_file, GL_VERTEX_SHADER);
-    GLuint fragment_shader = load_shader(fragment_shader_file, GL_FRAGMENT_SHADER);
+GLuint load_program(std::string_view vertex_shader_file, std::string_view fragment_shader_file,
+                    std::string_view header, std::string_view version) {
+    GLuint vertex_shader   = load_shader(vertex_shader_file, GL_VERTEX_SHADER, header, version);
+    GLuint fragment_shader = load_shader(fragment_shader_file, GL_FRAGMENT_SHADER, header, version);
 
     GLuint program = glCreateProgram();
 
@@ -17,11 +17,19 @@ struct Mesh {
     std::pmr::vector<coord> normals;
 };
 
-Mesh<> load_bunny_data(std::string_view obj_filename);
+// 三个数组都从 resource 分配内存的空网格
+// 注意 pmr::vector 的移动赋值不传播内存资源，两侧资源不同时会逐元素复制
+template <typename coord = float, typename index = std::uint32_t>
+Mesh<coord, index> make_mesh(std::pmr::memory_resource *resource) {
+    return {std::pmr::vector<coord>(resource), std::pmr::vector<index>(resource), std::pmr::vector<coord>(resource)};
+}
 
 Mesh<> genSolidSphere(GLfloat radius, GLint slices, GLint stacks);
 
-GLuint load_program(std::string_view vertex_shader_file, std::string_view fragment_shader_file);
+// header 为附加的源码（如宏定义），插入到两个着色器 #version 所在行之后
+// version 不为空时替换着色器文件第一行的 #version，如以 "#version 330 core" 用于 core profile
+GLuint load_program(std::string_view vertex_shader_file, std::string_view fragment_shader_file,
+                    std::string_view header = {}, std::string_view version = {});
 
 } // namespace glss
 